@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_adc/adc_continuous.h>
+
+// Streams one ADC1 pin in continuous mode: the ADC is paced by its own timer
+// and DMA fills frames in the background, so the sample rate does not depend
+// on when the reading task gets to run.
+class AdcStream {
+public:
+  static const uint32_t FRAME = 256; // conversions per DMA frame
+  static const uint32_t MAX_RATE = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+
+  bool begin(uint8_t pin, uint32_t rate = MAX_RATE);
+  bool start() { return adc_continuous_start(_handle) == ESP_OK; }
+  void stop() { adc_continuous_stop(_handle); }
+
+  uint32_t read(uint16_t *samples, uint32_t max, uint32_t timeout);
+
+protected:
+  adc_continuous_handle_t _handle = nullptr;
+  uint8_t _frame[FRAME * SOC_ADC_DIGI_RESULT_BYTES];
+};
+
+inline bool AdcStream::begin(uint8_t pin, uint32_t rate) {
+  adc_unit_t unit;
+  adc_channel_t channel;
+  adc_continuous_handle_cfg_t handleConfig = {};
+  adc_digi_pattern_config_t pattern = {};
+  adc_continuous_config_t config = {};
+
+  if (adc_continuous_io_to_channel(pin, &unit, &channel) != ESP_OK)
+    return false;
+  handleConfig.max_store_buf_size = sizeof(_frame) * 4;
+  handleConfig.conv_frame_size = sizeof(_frame);
+  if (adc_continuous_new_handle(&handleConfig, &_handle) != ESP_OK)
+    return false;
+
+  pattern.atten = ADC_ATTEN_DB_12;
+  pattern.channel = channel;
+  pattern.unit = unit;
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  config.pattern_num = 1;
+  config.adc_pattern = &pattern;
+  config.sample_freq_hz = rate;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  return adc_continuous_config(_handle, &config) == ESP_OK;
+}
+
+// Waits up to `timeout` ms for converted data and unpacks up to `max` raw
+// samples from it. Returns how many were written.
+inline uint32_t AdcStream::read(uint16_t *samples, uint32_t max,
+                                uint32_t timeout) {
+  uint32_t length = 0;
+  uint32_t count = 0;
+
+  if (adc_continuous_read(_handle, _frame, sizeof(_frame), &length, timeout) !=
+      ESP_OK)
+    return 0;
+  for (uint32_t i = 0;
+       (i + SOC_ADC_DIGI_RESULT_BYTES <= length) && (count < max);
+       i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t *result =
+        (const adc_digi_output_data_t *)&_frame[i];
+
+    samples[count++] = result->type2.data;
+  }
+  return count;
+}
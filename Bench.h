@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "BigReadout.h"
+#include "Curtain.h"
+#include "FrameBuffer.h"
+#include "Stats.h"
+#include "StripChart.h"
+
+// Drawing and capture scenarios timed the same way on the host and on the
+// device. A Meter does the measuring and the reporting:
+//
+//   template <class F> void measure(const char *name, uint32_t runs, F run);
+//
+// calls run(i) for i in [0, runs) and reports the cost of one run. The host
+// meter (host/bench.cpp) adds the bus counts from the SPI shim to the wall
+// time; the sketch's meter uses the CPU cycle counter. Both print lines
+// of the form
+//
+//   bench,<name>,<runs>,<ns>,<trans>,<bytes>,<cmds>,<dc>,<cs>
+//
+// with '-' for what a backend cannot see, so a Serial log can be grepped and
+// compared against a baseline with build/host/bench --compare.
+template <class Display> class Bench {
+public:
+  static const uint8_t CHANNELS = 3;
+
+  Bench(Display &display, FrameBuffer<Display> &fb, uint32_t ticksPerUs)
+      : _display(display), _fb(fb), _ticksPerUs(ticksPerUs) {}
+
+  static const char *header() {
+    return "# bench,name,runs,ns,trans,bytes,cmds,dc,cs\n";
+  }
+
+  // Leaves the panel and the frame buffer blank.
+  template <class Meter> void run(Meter &meter);
+
+protected:
+  uint8_t shot(Edge *edges, uint32_t start, float us) const;
+
+  Display &_display;
+  FrameBuffer<Display> &_fb;
+  uint32_t _ticksPerUs;
+};
+
+// A shot of `us` crossing the sensors 400us apart, with a glitch on each
+// opening edge.
+template <class Display>
+uint8_t Bench<Display>::shot(Edge *edges, uint32_t start, float us) const {
+  uint32_t width = us * _ticksPerUs, count = 0;
+
+  for (uint8_t i = 0; i < CHANNELS; ++i) {
+    uint32_t open = start + i * 400 * _ticksPerUs;
+
+    edges[count++] = {open, i, 1};
+    edges[count++] = {open + _ticksPerUs, i, 0};
+    edges[count++] = {open + 2 * _ticksPerUs, i, 1};
+    edges[count++] = {open + width, i, 0};
+  }
+  return count;
+}
+
+template <class Display>
+template <class Meter>
+void Bench<Display>::run(Meter &meter) {
+  static const uint16_t image[16 * 16] = {Display::RED, Display::GREEN,
+                                          Display::BLUE};
+  BigReadout<Display> big(_display, 4, 22);
+  StripChart<Display> chart(_display, 100, 8, 60, 64);
+  CurtainCorrelator correlator(CHANNELS, 5 * _ticksPerUs, 2000 * _ticksPerUs);
+  ShotStats stats(4000);
+
+  meter.measure("clear", 20, [&](uint32_t) { _display.clear(); });
+  meter.measure("fill 40x20", 200, [&](uint32_t i) {
+    _display.fill(10, 10, 40, 20, i & 1 ? Display::RED : Display::BLUE);
+  });
+  meter.measure("pixel", 1000, [&](uint32_t i) {
+    _display.pixel(i % Display::WIDTH, 5, Display::WHITE);
+  });
+  meter.measure("print 1/250", 200, [&](uint32_t) {
+    _display.print(0, 16, "1/250", Display::WHITE);
+  });
+  meter.measure("draw 16x16", 200,
+                [&](uint32_t) { _display.draw(20, 20, 16, 16, image); });
+
+  // Alternating texts, so every run has something to send.
+  _display.clear();
+  meter.measure("fb print flush", 100, [&](uint32_t i) {
+    _fb.print(0, 44, i & 1 ? "n=12  " : "n=13  ", Display::WHITE);
+    _fb.print(0, 62, i & 1 ? "+0.03EV" : "-0.10EV", Display::WHITE);
+    _fb.flush();
+  });
+  big.print("1/250");
+  meter.measure("big digit", 100,
+                [&](uint32_t i) { big.print(i & 1 ? "1/250" : "1/251"); });
+
+  chart.range(-1, 1, 0);
+  chart.begin();
+  meter.measure("chart add", 200, [&](uint32_t i) {
+    chart.add((int32_t)(i % 21) / 10.0f - 1);
+  });
+  chart.end();
+
+  // Edges of one shot to the number on the panel.
+  _display.clear();
+  big.invalidate();
+  meter.measure("edges to readout", 100, [&](uint32_t i) {
+    Edge edges[4 * CHANNELS];
+    uint8_t count = shot(edges, i * 100000 * _ticksPerUs, 4000 + 100 * (i & 1));
+    ShotRecord record;
+    char text[16];
+
+    for (uint8_t j = 0; j < count; ++j)
+      correlator.feed(edges[j]);
+    correlator.poll(edges[count - 1].ticks + 10 * _ticksPerUs);
+    while (correlator.pop(record)) {
+      float us = (float)record.exposure() / _ticksPerUs;
+
+      stats.add(us);
+      snprintf(text, sizeof(text), "1/%.0f", 1000000.0f / us);
+      big.print(text);
+    }
+  });
+
+  _fb.clear();
+  _fb.flush();
+  _display.clear();
+}
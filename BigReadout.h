@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Large seven-segment readout for the measured speed. Digits, '-', '/' (drawn
+// as b, g and e) and ' ' take a full cell, '.' a narrow one; the first other
+// character starts a suffix ("ms", "s") printed in the display's small font
+// on the baseline. Segment rectangles and glyph masks are worked out at
+// compile time from the cell size, so the font costs no flash beyond a few
+// bytes per glyph.
+//
+// The readout remembers what is on the panel. Where a cell keeps its place
+// only the segments that changed are filled, so "1/250" to "1/251" touches
+// four small rectangles; cells that moved are redrawn whole.
+template <class Display, const uint8_t W = 18, const uint8_t H = 36,
+          const uint8_t T = 4>
+class BigReadout {
+  static_assert((W > 2 * T) && (H > 4 * T), "strokes must fit the cell");
+
+public:
+  static const uint8_t MAX_CELLS = 8;
+  static const uint8_t MAX_SUFFIX = 4;
+
+  struct Segment {
+    uint8_t x, y, w, h;
+  };
+
+  // a to g clockwise from the top, then the decimal point.
+  static constexpr Segment segment(uint8_t i) {
+    constexpr uint8_t MID = (H - T) / 2;
+
+    switch (i) {
+    case 0:
+      return {T, 0, W - 2 * T, T};
+    case 1:
+      return {W - T, T, T, MID - T};
+    case 2:
+      return {W - T, MID + T, T, H - MID - 2 * T};
+    case 3:
+      return {T, H - T, W - 2 * T, T};
+    case 4:
+      return {0, MID + T, T, H - MID - 2 * T};
+    case 5:
+      return {0, T, T, MID - T};
+    case 6:
+      return {T, MID, W - 2 * T, T};
+    default:
+      return {0, H - T, T, T};
+    }
+  }
+
+  static constexpr uint8_t glyph(char c) {
+    constexpr uint8_t DIGITS[] = {0x3F, 0x06, 0x5B, 0x4F, 0x66,
+                                  0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+    return (c >= '0') && (c <= '9') ? DIGITS[c - '0']
+           : c == '-'               ? 0x40
+           : c == '/'               ? 0x52
+           : c == '.'               ? 0x80
+                                    : 0x00;
+  }
+
+  static constexpr bool big(char c) {
+    return ((c >= '0') && (c <= '9')) || (c == '-') || (c == '/') ||
+           (c == '.') || (c == ' ');
+  }
+  static constexpr uint8_t advance(char c) { return (c == '.' ? T : W) + T; }
+
+  BigReadout(Display &display, uint8_t x, uint8_t y)
+      : _display(display), _x(x), _y(y) {}
+
+  void colors(uint16_t cf, uint16_t cb) {
+    _cf = cf;
+    _cb = cb;
+    invalidate();
+  }
+
+  void print(const char *text);
+  void clear();
+  // Forget what is on the panel, e.g. after it was cleared behind our back;
+  // the next print() redraws everything.
+  void invalidate() {
+    _cells = 0;
+    _suffix[0] = 0;
+    _end = _x;
+  }
+
+protected:
+  struct Cell {
+    uint8_t x;
+    uint8_t w;
+    uint8_t mask;
+  };
+
+  void segments(uint8_t x, uint8_t mask, uint8_t changed);
+
+  Display &_display;
+  uint8_t _x, _y;
+  uint16_t _cf = 0xFFFF;
+  uint16_t _cb = 0;
+  Cell _cell[MAX_CELLS];
+  uint8_t _cells = 0;
+  char _suffix[MAX_SUFFIX + 1] = {};
+  uint8_t _suffixX = 0;
+  uint8_t _end = 0; // right edge of everything drawn
+};
+
+template <class Display, const uint8_t W, const uint8_t H, const uint8_t T>
+void BigReadout<Display, W, H, T>::segments(uint8_t x, uint8_t mask,
+                                            uint8_t changed) {
+  for (uint8_t i = 0; i < 8; ++i) {
+    if (changed & (1 << i)) {
+      Segment s = segment(i);
+
+      _display.fill(x + s.x, _y + s.y, s.w, s.h,
+                    (mask & (1 << i)) ? _cf : _cb);
+    }
+  }
+}
+
+template <class Display, const uint8_t W, const uint8_t H, const uint8_t T>
+void BigReadout<Display, W, H, T>::print(const char *text) {
+  uint8_t x = _x, n = 0, end;
+  const char *suffix;
+
+  for (; *text && big(*text) && (n < MAX_CELLS); ++text, ++n) {
+    Cell cell = {x, advance(*text), glyph(*text)};
+
+    if ((n < _cells) && (_cell[n].x == cell.x) && (_cell[n].w == cell.w)) {
+      segments(x, cell.mask, cell.mask ^ _cell[n].mask);
+    } else {
+      _display.fill(x, _y, cell.w, H, _cb);
+      segments(x, cell.mask, cell.mask);
+    }
+    _cell[n] = cell;
+    x += cell.w;
+  }
+  _cells = n;
+
+  suffix = text;
+  end = x + strlen(suffix) * _display.charWidth();
+  if ((x != _suffixX) || strncmp(suffix, _suffix, MAX_SUFFIX)) {
+    // Whatever was right of the cells goes: dropped cells, the old suffix.
+    if (_end > x)
+      _display.fill(x, _y, _end - x, H, _cb);
+    if (*suffix)
+      _display.print(x, _y + H - _display.charHeight(), suffix, _cf, _cb);
+    strncpy(_suffix, suffix, MAX_SUFFIX);
+    _suffixX = x;
+  }
+  _end = end;
+}
+
+template <class Display, const uint8_t W, const uint8_t H, const uint8_t T>
+void BigReadout<Display, W, H, T>::clear() {
+  if (_end > _x)
+    _display.fill(_x, _y, _end - _x, H, _cb);
+  invalidate();
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "Curtain.h"
+
+// Per-unit sensor latency, measured by flashing an LED at the sensors for a
+// known time. Each edge reaches the capture path late by the photodiode rise
+// or fall time, the comparator delay and the ISR entry; rise and fall differ,
+// so every exposure comes out too long or too short by a constant, and short
+// pulses that never fully charge the photodiode drift further. The table
+// holds the per-channel offsets of both edges, taken from the longest pulse,
+// and what is left of the width error at each calibrated width. Everything is
+// in ticks of the clock it was measured with.
+struct LatencyTable {
+  static const uint16_t VERSION = 1;
+  static const uint8_t POINTS = 8;
+  static const uint8_t MAX_CHANNELS = ShotRecord::MAX_CHANNELS;
+
+  uint16_t version = 0;
+  uint8_t channels = 0;
+  uint8_t points = 0;
+  uint32_t ticksPerUs = 0;
+  int32_t rise[MAX_CHANNELS] = {}; // drive on to light seen
+  int32_t fall[MAX_CHANNELS] = {}; // drive off to dark seen
+  uint32_t width[POINTS] = {};     // calibrated pulse widths, ascending
+  int32_t error[POINTS][MAX_CHANNELS] = {}; // left after the edge offsets
+
+  bool valid() const { return (version == VERSION) && points; }
+  // Width error expected on `channel` for a width already corrected by the
+  // edge offsets: linear between calibrated widths, flat beyond them.
+  int32_t residual(uint8_t channel, int32_t ticks) const;
+  // Takes the latency out of every channel that saw light.
+  void apply(ShotRecord &record) const;
+};
+
+// Gathers pulses one width at a time, shortest first, and fits a table. A
+// pulse counts only if every channel saw it; the offsets are medians, so the
+// odd edge held up behind another interrupt does not move them.
+class LatencyCalibrator {
+public:
+  static const uint8_t REPS = 32;
+  static const uint8_t MIN_REPS = 3;
+
+  explicit LatencyCalibrator(uint8_t channels)
+      : _channels(channels < LatencyTable::MAX_CHANNELS
+                      ? channels
+                      : LatencyTable::MAX_CHANNELS) {}
+
+  void reset() { _points = 0; }
+  // Starts the next, wider, point; false once the table is full.
+  bool begin(uint32_t width);
+  // A pulse driven from `on` to `off` and what the sensors made of it.
+  bool add(uint32_t on, uint32_t off, const ShotRecord &record);
+  uint8_t count() const { return _points ? _reps[_points - 1] : 0; }
+
+  bool fit(LatencyTable &table, uint32_t ticksPerUs) const;
+
+protected:
+  static int32_t median(int32_t *values, uint8_t count);
+
+  uint8_t _channels;
+  uint8_t _points = 0;
+  uint32_t _width[LatencyTable::POINTS];
+  uint8_t _reps[LatencyTable::POINTS] = {};
+  int32_t _rise[LatencyTable::POINTS][REPS][LatencyTable::MAX_CHANNELS];
+  int32_t _fall[LatencyTable::POINTS][REPS][LatencyTable::MAX_CHANNELS];
+};
+
+inline int32_t LatencyTable::residual(uint8_t channel, int32_t ticks) const {
+  if (!points)
+    return 0;
+
+  int32_t x0 = width[0] + error[0][channel];
+
+  if (ticks <= x0)
+    return error[0][channel];
+  for (uint8_t i = 1; i < points; ++i) {
+    int32_t x1 = width[i] + error[i][channel];
+
+    if ((ticks <= x1) && (x1 > x0)) {
+      int32_t e0 = error[i - 1][channel], e1 = error[i][channel];
+
+      return e0 + (int64_t)(e1 - e0) * (ticks - x0) / (x1 - x0);
+    }
+    x0 = x1;
+  }
+  return error[points - 1][channel];
+}
+
+inline void LatencyTable::apply(ShotRecord &record) const {
+  for (uint8_t i = 0; (i < record.channels) && (i < channels); ++i) {
+    if (!(record.mask & (1 << i)))
+      continue;
+
+    int32_t ticks = (int32_t)record.width[i] - (fall[i] - rise[i]);
+
+    ticks -= residual(i, ticks);
+    record.open[i] -= rise[i];
+    record.width[i] = ticks > 0 ? ticks : 0;
+  }
+}
+
+inline bool LatencyCalibrator::begin(uint32_t width) {
+  if ((_points == LatencyTable::POINTS) ||
+      (_points && (width <= _width[_points - 1])))
+    return false;
+  _width[_points] = width;
+  _reps[_points] = 0;
+  ++_points;
+  return true;
+}
+
+inline bool LatencyCalibrator::add(uint32_t on, uint32_t off,
+                                   const ShotRecord &record) {
+  uint8_t all = (1 << _channels) - 1;
+
+  if (!_points || (_reps[_points - 1] == REPS) || ((record.mask & all) != all))
+    return false;
+
+  uint8_t point = _points - 1, rep = _reps[point];
+
+  for (uint8_t i = 0; i < _channels; ++i) {
+    _rise[point][rep][i] = record.open[i] - on;
+    _fall[point][rep][i] = record.open[i] + record.width[i] - off;
+  }
+  ++_reps[point];
+  return true;
+}
+
+inline int32_t LatencyCalibrator::median(int32_t *values, uint8_t count) {
+  std::nth_element(values, values + count / 2, values + count);
+  return values[count / 2];
+}
+
+inline bool LatencyCalibrator::fit(LatencyTable &table,
+                                   uint32_t ticksPerUs) const {
+  int32_t values[REPS];
+
+  if (!_points)
+    return false;
+  for (uint8_t point = 0; point < _points; ++point) {
+    if (_reps[point] < MIN_REPS)
+      return false;
+  }
+
+  uint8_t last = _points - 1;
+
+  table = LatencyTable();
+  for (uint8_t i = 0; i < _channels; ++i) {
+    for (uint8_t rep = 0; rep < _reps[last]; ++rep)
+      values[rep] = _rise[last][rep][i];
+    table.rise[i] = median(values, _reps[last]);
+    for (uint8_t rep = 0; rep < _reps[last]; ++rep)
+      values[rep] = _fall[last][rep][i];
+    table.fall[i] = median(values, _reps[last]);
+
+    for (uint8_t point = 0; point < _points; ++point) {
+      for (uint8_t rep = 0; rep < _reps[point]; ++rep)
+        values[rep] = _fall[point][rep][i] - _rise[point][rep][i];
+      table.error[point][i] = median(values, _reps[point]) -
+                              (table.fall[i] - table.rise[i]);
+    }
+  }
+  for (uint8_t point = 0; point < _points; ++point)
+    table.width[point] = _width[point];
+  table.version = LatencyTable::VERSION;
+  table.channels = _channels;
+  table.points = _points;
+  table.ticksPerUs = ticksPerUs;
+  return true;
+}
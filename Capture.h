@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+// A single photodiode transition, timestamped in CPU cycles by the ISR.
+struct Edge {
+  uint32_t ticks;
+  uint8_t channel; // sensor the edge came from
+  uint8_t level;   // 1 = light on, 0 = light off
+};
+
+// One measured exposure: the open timestamp and the open duration in ticks.
+struct Exposure {
+  uint32_t start;
+  uint32_t ticks;
+};
+
+// Pairs light on/off edges into exposures. Knows nothing about the hardware:
+// edges come in as cycle counts, so it runs the same against an ISR or a
+// recorded trace. A dip shorter than `glitch` ticks inside an exposure (sensor
+// ringing, curtain bounce) is merged into it, which means an exposure is only
+// reported once the next edge arrives or poll() sees the glitch window expire.
+class ExposureDetector {
+public:
+  explicit ExposureDetector(uint32_t glitch = 0) : _glitch(glitch) {}
+
+  bool feed(const Edge &edge, Exposure &out);
+  bool poll(uint32_t now, Exposure &out);
+  void reset() { _state = IDLE; }
+
+  uint32_t glitch() const { return _glitch; }
+  void glitch(uint32_t ticks) { _glitch = ticks; }
+
+protected:
+  enum State : uint8_t { IDLE, OPEN, CLOSING };
+
+  uint32_t _glitch;
+  uint32_t _start = 0;
+  uint32_t _end = 0;
+  State _state = IDLE;
+};
+
+inline bool ExposureDetector::feed(const Edge &edge, Exposure &out) {
+  bool ready = false;
+
+  if (edge.level) {
+    switch (_state) {
+    case IDLE:
+      _start = edge.ticks;
+      _state = OPEN;
+      break;
+    case OPEN:
+      break;
+    case CLOSING:
+      if (edge.ticks - _end < _glitch) {
+        _state = OPEN;
+      } else {
+        out = {_start, _end - _start};
+        ready = true;
+        _start = edge.ticks;
+        _state = OPEN;
+      }
+      break;
+    }
+  } else if (_state == OPEN) {
+    _end = edge.ticks;
+    _state = CLOSING;
+    if (!_glitch)
+      return poll(_end, out);
+  }
+  return ready;
+}
+
+inline bool ExposureDetector::poll(uint32_t now, Exposure &out) {
+  if ((_state == CLOSING) && (now - _end >= _glitch)) {
+    out = {_start, _end - _start};
+    _state = IDLE;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Capture.h"
+
+// One shot as seen by up to MAX_CHANNELS sensors placed along the direction
+// of curtain travel, channel 0 first. Times are skew-compensated ticks.
+struct ShotRecord {
+  static const uint8_t MAX_CHANNELS = 3;
+
+  uint8_t channels;
+  uint8_t mask; // channels that saw light
+  uint32_t open[MAX_CHANNELS];
+  uint32_t width[MAX_CHANNELS];
+
+  bool complete() const { return mask == (1 << channels) - 1; }
+  uint8_t first() const;
+  uint8_t last() const;
+
+  // First and second curtain travel between the outermost sensors that fired;
+  // negative when the curtain runs from the last sensor to the first.
+  int32_t openTravel() const { return open[last()] - open[first()]; }
+  int32_t closeTravel() const;
+
+  uint32_t exposure() const;
+  uint32_t spread() const;
+};
+
+// Correlates per-channel exposures into shot records. Each channel has its
+// own ExposureDetector; exposures that start within `window` ticks of the
+// first one belong to the same shot, so `window` must exceed the curtain
+// travel time. A record is ready as soon as every channel has reported, or
+// once poll() sees no other channel close within `window` of the first. Work
+// per edge is constant, so long sessions cost nothing extra.
+class CurtainCorrelator {
+public:
+  CurtainCorrelator(uint8_t channels, uint32_t glitch, uint32_t window);
+
+  void feed(const Edge &edge);
+  void poll(uint32_t now);
+  bool pop(ShotRecord &record);
+
+  // Per-channel latency subtracted from every open time.
+  int32_t skew(uint8_t channel) const { return _skew[channel]; }
+  void skew(uint8_t channel, int32_t ticks) { _skew[channel] = ticks; }
+  // Takes the skews from a shot where every sensor saw light at the same
+  // instant (a flash, or the lens cap off with the shutter on B).
+  void calibrate(const ShotRecord &simultaneous);
+
+  uint32_t dropped() const { return _dropped; }
+
+protected:
+  static const uint8_t READY = 4;
+
+  void add(uint8_t channel, const Exposure &exposure);
+  void emit();
+
+  uint8_t _channels;
+  uint32_t _window;
+  ExposureDetector _detectors[ShotRecord::MAX_CHANNELS];
+  int32_t _skew[ShotRecord::MAX_CHANNELS] = {};
+  ShotRecord _pending;
+  uint32_t _closed = 0;
+  ShotRecord _ready[READY];
+  uint8_t _readyHead = 0;
+  uint8_t _readyCount = 0;
+  uint32_t _dropped = 0;
+};
+
+inline uint8_t ShotRecord::first() const {
+  for (uint8_t i = 0; i < channels; ++i) {
+    if (mask & (1 << i))
+      return i;
+  }
+  return 0;
+}
+
+inline uint8_t ShotRecord::last() const {
+  for (uint8_t i = channels; i > 0; --i) {
+    if (mask & (1 << (i - 1)))
+      return i - 1;
+  }
+  return 0;
+}
+
+inline int32_t ShotRecord::closeTravel() const {
+  return (open[last()] + width[last()]) - (open[first()] + width[first()]);
+}
+
+// Mean exposure over the sensors that fired.
+inline uint32_t ShotRecord::exposure() const {
+  uint64_t sum = 0;
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < channels; ++i) {
+    if (mask & (1 << i)) {
+      sum += width[i];
+      ++count;
+    }
+  }
+  return count ? sum / count : 0;
+}
+
+// Largest difference in exposure between sensor positions.
+inline uint32_t ShotRecord::spread() const {
+  uint32_t lo = UINT32_MAX, hi = 0;
+
+  for (uint8_t i = 0; i < channels; ++i) {
+    if (mask & (1 << i)) {
+      if (width[i] < lo)
+        lo = width[i];
+      if (width[i] > hi)
+        hi = width[i];
+    }
+  }
+  return hi > lo ? hi - lo : 0;
+}
+
+inline CurtainCorrelator::CurtainCorrelator(uint8_t channels, uint32_t glitch,
+                                            uint32_t window)
+    : _channels(channels < ShotRecord::MAX_CHANNELS ? channels
+                                                    : ShotRecord::MAX_CHANNELS),
+      _window(window) {
+  for (ExposureDetector &detector : _detectors)
+    detector.glitch(glitch);
+  _pending.channels = _channels;
+  _pending.mask = 0;
+}
+
+inline void CurtainCorrelator::feed(const Edge &edge) {
+  Exposure exposure;
+
+  if ((edge.channel < _channels) &&
+      _detectors[edge.channel].feed(edge, exposure))
+    add(edge.channel, exposure);
+}
+
+inline void CurtainCorrelator::poll(uint32_t now) {
+  Exposure exposure;
+
+  for (uint8_t i = 0; i < _channels; ++i) {
+    if (_detectors[i].poll(now, exposure))
+      add(i, exposure);
+  }
+  if (_pending.mask && (now - _closed > _window))
+    emit();
+}
+
+inline bool CurtainCorrelator::pop(ShotRecord &record) {
+  if (!_readyCount)
+    return false;
+  record = _ready[_readyHead];
+  _readyHead = (_readyHead + 1) % READY;
+  --_readyCount;
+  return true;
+}
+
+inline void CurtainCorrelator::calibrate(const ShotRecord &simultaneous) {
+  uint32_t reference = simultaneous.open[simultaneous.first()];
+
+  for (uint8_t i = 0; i < _channels; ++i) {
+    if (simultaneous.mask & (1 << i))
+      _skew[i] += simultaneous.open[i] - reference;
+  }
+}
+
+inline void CurtainCorrelator::add(uint8_t channel,
+                                   const Exposure &exposure) {
+  uint32_t open = exposure.start - _skew[channel];
+
+  // A second exposure on a channel, or one outside the window, is the next
+  // shot: whatever has been gathered so far goes out incomplete.
+  if (_pending.mask && ((_pending.mask & (1 << channel)) ||
+                        (int32_t)(open - _pending.open[_pending.first()]) >
+                            (int32_t)_window))
+    emit();
+  if (!_pending.mask)
+    _closed = exposure.start + exposure.ticks;
+  _pending.open[channel] = open;
+  _pending.width[channel] = exposure.ticks;
+  _pending.mask |= 1 << channel;
+  if (_pending.complete())
+    emit();
+}
+
+inline void CurtainCorrelator::emit() {
+  if (_readyCount == READY) {
+    ++_dropped;
+  } else {
+    _ready[(_readyHead + _readyCount) % READY] = _pending;
+    ++_readyCount;
+  }
+  _pending.mask = 0;
+}
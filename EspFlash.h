@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#include <atomic>
+
+// Raw access to a data partition for ShotLog. By default this takes the
+// "spiffs" partition of the stock Arduino partition tables, which nothing
+// else in the sketch uses.
+//
+// Every operation turns the flash cache off, and with it every interrupt
+// handler not marked IRAM-safe, which attachInterrupt() ones are not: an edge
+// that arrives meanwhile is taken once the operation ends, late by up to a
+// sector erase. The cycle counts around the last operation are kept so the
+// capture path can tell which edges that may have happened to.
+class EspFlash {
+public:
+  static const uint32_t SECTOR = SPI_FLASH_SEC_SIZE;
+
+  bool begin(const char *label = nullptr);
+
+  uint32_t size() const { return _partition ? _partition->size : 0; }
+  bool read(uint32_t address, void *data, uint32_t count) {
+    return guard([&] {
+      return esp_partition_read(_partition, address, data, count) == ESP_OK;
+    });
+  }
+  bool write(uint32_t address, const void *data, uint32_t count) {
+    return guard([&] {
+      return esp_partition_write(_partition, address, data, count) == ESP_OK;
+    });
+  }
+  bool erase(uint32_t address) {
+    return guard([&] {
+      return esp_partition_erase_range(_partition, address, SECTOR) == ESP_OK;
+    });
+  }
+
+  // Runs `op`, which stops the cache, as a tracked operation. For flash work
+  // outside this class, such as NVS.
+  template <class F> bool guard(F op);
+  // Whether an edge stamped `ticks` may have waited for an operation: it is
+  // no earlier than the start of the last one, and that one is still running
+  // or ended at most `slack` ticks before. Safe to call from another task
+  // than the one doing the operations.
+  bool stalled(uint32_t ticks, uint32_t slack) const;
+
+protected:
+  const esp_partition_t *_partition = nullptr;
+  // Written by the operating task only.
+  std::atomic<uint32_t> _from{0};
+  std::atomic<uint32_t> _to{0};
+  std::atomic<bool> _busy{false};
+};
+
+inline bool EspFlash::begin(const char *label) {
+  _partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, label);
+  return _partition;
+}
+
+template <class F> bool EspFlash::guard(F op) {
+  _from.store(ESP.getCycleCount(), std::memory_order_relaxed);
+  _busy.store(true, std::memory_order_release);
+
+  bool done = op();
+
+  _to.store(ESP.getCycleCount(), std::memory_order_relaxed);
+  _busy.store(false, std::memory_order_release);
+  return done;
+}
+
+inline bool EspFlash::stalled(uint32_t ticks, uint32_t slack) const {
+  bool busy = _busy.load(std::memory_order_acquire);
+
+  if ((int32_t)(ticks - _from.load(std::memory_order_relaxed)) < 0)
+    return false;
+  return busy ||
+         ((int32_t)(_to.load(std::memory_order_relaxed) + slack - ticks) >= 0);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+
+// Takes mains flicker out of the photodiode samples before LightProfile sees
+// them. Room lighting ripples at twice the mains frequency, which at slow
+// speeds crosses a fixed trigger and at fast ones tilts the baseline under
+// the pulse. The ambient light is learnt as a template over one ripple
+// period, one bin per sample phase, and subtracted from every sample, so the
+// output is the light added to the room plus the room's mean level. Each bin
+// is an exponential average over the periods it was idle in, so the template
+// follows slow drift in level and in mains frequency.
+//
+// The gate that keeps pulses out of the template is adaptive: it opens when
+// the residual rises `ON_SHIFT` bits above its own mean deviation (never
+// below `floor`) and closes once it has stayed under half that for an
+// eighth of a period. Light that stays on for RELEARN periods, 17s or more
+// at either mains frequency and so past the slowest marked speed a stop
+// slow, is taken as a change of scene and learnt afresh; learning a long
+// exposure as ambient would leave the template wrong once it ends. All
+// integer, constant work per sample.
+class FlickerFilter {
+public:
+  static const uint16_t MAX_PERIOD = 1024;
+  static const uint8_t BITS = 12;
+  static const uint16_t RELEARN = 2048; // periods
+
+  // `period` is the sample rate over the ripple frequency; it need not be a
+  // whole number of samples.
+  FlickerFilter(float period, uint16_t floor);
+
+  void process(uint16_t *samples, uint32_t count);
+  void reset() { _primed = false; }
+
+  // Residual over the template that opens the gate.
+  uint16_t threshold() const;
+  bool active() const { return _active; }
+  // Peak to peak of the learnt ripple.
+  uint16_t ripple() const;
+
+protected:
+  static const uint8_t FRACTION = 4; // template and level fraction bits
+  static const uint8_t TEMPLATE_SHIFT = 3;
+  static const uint8_t LEVEL_SHIFT = 12;
+  static const uint8_t NOISE_SHIFT = 10;
+  static const uint8_t ON_SHIFT = 2;
+
+  uint32_t _period; // 16.16 samples
+  uint16_t _bins;
+  uint16_t _floor;
+  uint32_t _phase = 0; // 16.16 samples into the period
+  bool _primed = false;
+  bool _learning = false; // first period: copy samples straight in
+  bool _active = false;
+  uint32_t _below = 0;
+  uint32_t _lit = 0;
+  uint32_t _level = 0; // mean ambient, LEVEL_SHIFT + FRACTION fraction bits
+  uint32_t _noise = 0; // mean |residual|, NOISE_SHIFT fraction bits
+  uint16_t _ambient[MAX_PERIOD];
+};
+
+inline FlickerFilter::FlickerFilter(float period, uint16_t floor)
+    : _floor(floor) {
+  if (period > MAX_PERIOD)
+    period = MAX_PERIOD;
+  if (period < 1)
+    period = 1;
+  _period = (uint32_t)(period * 65536);
+  _bins = (_period + 0xFFFF) >> 16;
+}
+
+inline uint16_t FlickerFilter::threshold() const {
+  uint32_t on = (_noise >> NOISE_SHIFT) << ON_SHIFT;
+
+  return on > _floor ? on : _floor;
+}
+
+inline uint16_t FlickerFilter::ripple() const {
+  uint16_t lo = UINT16_MAX, hi = 0;
+
+  for (uint16_t i = 0; i < _bins; ++i) {
+    if (_ambient[i] < lo)
+      lo = _ambient[i];
+    if (_ambient[i] > hi)
+      hi = _ambient[i];
+  }
+  return hi > lo ? (hi - lo) >> FRACTION : 0;
+}
+
+inline void FlickerFilter::process(uint16_t *samples, uint32_t count) {
+  const uint16_t MAX = (1 << BITS) - 1;
+  uint16_t on = threshold();
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t sample = samples[i] & MAX;
+    uint16_t bin = _phase >> 16;
+
+    if (!_primed) {
+      _phase = 0;
+      bin = 0;
+      _level = (uint32_t)sample << (LEVEL_SHIFT + FRACTION);
+      _noise = 0;
+      _active = false;
+      _learning = true;
+      _primed = true;
+    }
+    if (_learning)
+      _ambient[bin] = sample << FRACTION;
+
+    int32_t residual = sample - (_ambient[bin] >> FRACTION);
+
+    if (_active) {
+      if (residual < on / 2) {
+        if (++_below >= _bins / 8)
+          _active = false;
+      } else {
+        _below = 0;
+      }
+      if (++_lit >= (uint32_t)RELEARN * _bins)
+        _primed = false;
+    } else if (residual > on) {
+      _active = true;
+      _below = 0;
+      _lit = 0;
+    } else {
+      uint32_t deviation = residual < 0 ? -residual : residual;
+
+      _ambient[bin] += ((int32_t)(sample << FRACTION) - _ambient[bin]) >>
+                       TEMPLATE_SHIFT;
+      _level += (sample << FRACTION) - (_level >> LEVEL_SHIFT);
+      _noise += deviation - (_noise >> NOISE_SHIFT);
+      on = threshold();
+    }
+
+    int32_t out = residual + (_level >> (LEVEL_SHIFT + FRACTION));
+
+    samples[i] = out < 0 ? 0 : out > MAX ? MAX : out;
+
+    _phase += 1 << 16;
+    if (_phase >= _period) {
+      _phase -= _period;
+      _learning = false;
+    }
+  }
+}
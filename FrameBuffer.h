@@ -0,0 +1,236 @@
+#pragma once
+
+#include <stdint.h>
+
+// Off-screen RGB565 copy of the panel. Primitives draw into RAM and only the
+// pixels that actually changed are marked dirty; flush() then pushes the dirty
+// rectangles to the display, one window burst each. Redrawing a readout with
+// the same text costs nothing on the bus, and overlapping draws (background,
+// text, highlight) reach the panel once.
+template <class Display> class FrameBuffer {
+public:
+  static const uint8_t WIDTH = Display::WIDTH;
+  static const uint8_t HEIGHT = Display::HEIGHT;
+
+  explicit FrameBuffer(Display &display) : _display(display) {}
+
+  uint8_t width() const { return WIDTH; }
+  uint8_t height() const { return HEIGHT; }
+
+  void fill(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t c);
+  void clear(uint16_t c = 0) { fill(0, 0, WIDTH, HEIGHT, c); }
+  void pixel(uint8_t x, uint8_t y, uint16_t c) { fill(x, y, 1, 1, c); }
+  void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *data);
+  void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t *bits,
+            uint16_t cf, uint16_t cb = 0);
+
+  uint8_t charWidth() const { return _display.charWidth(); }
+  uint8_t charHeight() const { return _display.charHeight(); }
+
+  void print(uint8_t x, uint8_t y, char c, uint16_t cf, uint16_t cb = 0);
+  void print(uint8_t x, uint8_t y, const char *str, uint16_t cf,
+             uint16_t cb = 0);
+
+  bool dirty() const { return _count; }
+  bool flush(uint32_t budget = UINT32_MAX);
+
+  const uint16_t *pixels() const { return _pixels; }
+
+protected:
+  static const uint8_t MAX_RECTS = 8;
+  // Pixels a merge may add before two rectangles are worth separate windows;
+  // roughly the bytes of a CASET/RASET/RAMWR preamble.
+  static const uint16_t MERGE_SLACK = 8;
+
+  struct Rect {
+    uint8_t x0, y0, x1, y1; // inclusive
+
+    uint16_t area() const { return (x1 - x0 + 1) * (y1 - y0 + 1); }
+    Rect merge(const Rect &r) const;
+  };
+
+  // Tracks the bounding box of the pixels a primitive really changed.
+  struct Changes {
+    Rect rect = {0xFF, 0xFF, 0, 0};
+
+    void set(uint16_t *p, uint16_t c, uint8_t x, uint8_t y);
+  };
+
+  bool clip(uint8_t x, uint8_t y, uint8_t &w, uint8_t &h) const;
+  void mark(const Changes &changes);
+  void remove(uint8_t i) { _rects[i] = _rects[--_count]; }
+
+  Display &_display;
+  uint16_t _pixels[WIDTH * HEIGHT] = {};
+  Rect _rects[MAX_RECTS];
+  uint8_t _count = 0;
+};
+
+template <class Display>
+typename FrameBuffer<Display>::Rect
+FrameBuffer<Display>::Rect::merge(const Rect &r) const {
+  return {x0 < r.x0 ? x0 : r.x0, y0 < r.y0 ? y0 : r.y0,
+          x1 > r.x1 ? x1 : r.x1, y1 > r.y1 ? y1 : r.y1};
+}
+
+template <class Display>
+inline void FrameBuffer<Display>::Changes::set(uint16_t *p, uint16_t c,
+                                               uint8_t x, uint8_t y) {
+  if (*p != c) {
+    *p = c;
+    if (x < rect.x0)
+      rect.x0 = x;
+    if (x > rect.x1)
+      rect.x1 = x;
+    if (y < rect.y0)
+      rect.y0 = y;
+    if (y > rect.y1)
+      rect.y1 = y;
+  }
+}
+
+template <class Display>
+bool FrameBuffer<Display>::clip(uint8_t x, uint8_t y, uint8_t &w,
+                                uint8_t &h) const {
+  if ((x >= WIDTH) || (y >= HEIGHT))
+    return false;
+  if (x + w > WIDTH)
+    w = WIDTH - x;
+  if (y + h > HEIGHT)
+    h = HEIGHT - y;
+  return w && h;
+}
+
+template <class Display>
+void FrameBuffer<Display>::fill(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                                uint16_t c) {
+  Changes changes;
+
+  if (!clip(x, y, w, h))
+    return;
+  for (uint8_t _y = y; _y < y + h; ++_y) {
+    uint16_t *p = &_pixels[_y * WIDTH + x];
+
+    for (uint8_t _x = x; _x < x + w; ++_x) {
+      changes.set(p++, c, _x, _y);
+    }
+  }
+  mark(changes);
+}
+
+template <class Display>
+void FrameBuffer<Display>::draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                                const uint16_t *data) {
+  uint8_t _w = w, _h = h;
+  Changes changes;
+
+  if (!clip(x, y, _w, _h))
+    return;
+  for (uint8_t _y = 0; _y < _h; ++_y) {
+    uint16_t *p = &_pixels[(y + _y) * WIDTH + x];
+
+    for (uint8_t _x = 0; _x < _w; ++_x) {
+      changes.set(p++, data[_y * w + _x], x + _x, y + _y);
+    }
+  }
+  mark(changes);
+}
+
+template <class Display>
+void FrameBuffer<Display>::draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                                const uint8_t *bits, uint16_t cf,
+                                uint16_t cb) {
+  uint8_t _w = w, _h = h;
+  Changes changes;
+
+  if (!clip(x, y, _w, _h))
+    return;
+  for (uint8_t _y = 0; _y < _h; ++_y) {
+    uint16_t *p = &_pixels[(y + _y) * WIDTH + x];
+
+    for (uint8_t _x = 0; _x < _w; ++_x) {
+      changes.set(p++, (bits[(_y / 8) * w + _x] & (1 << (_y % 8))) ? cf : cb,
+                  x + _x, y + _y);
+    }
+  }
+  mark(changes);
+}
+
+template <class Display>
+void FrameBuffer<Display>::print(uint8_t x, uint8_t y, char c, uint16_t cf,
+                                 uint16_t cb) {
+  draw(x, y, Display::FONT_WIDTH, Display::FONT_HEIGHT, Display::glyph(c), cf,
+       cb);
+  fill(x + Display::FONT_WIDTH, y, Display::FONT_GAP, Display::FONT_HEIGHT,
+       cb);
+}
+
+template <class Display>
+void FrameBuffer<Display>::print(uint8_t x, uint8_t y, const char *str,
+                                 uint16_t cf, uint16_t cb) {
+  while (*str && (x < WIDTH)) {
+    print(x, y, *str++, cf, cb);
+    x += charWidth();
+  }
+}
+
+// Folds a newly changed area into the dirty list: anything it overlaps or
+// nearly touches is absorbed, and when the list is full the pair whose merge
+// wastes the fewest pixels is combined.
+template <class Display>
+void FrameBuffer<Display>::mark(const Changes &changes) {
+  Rect rect = changes.rect;
+
+  if (rect.x0 > rect.x1)
+    return;
+  for (uint8_t i = 0; i < _count;) {
+    Rect merged = rect.merge(_rects[i]);
+
+    if (merged.area() <= rect.area() + _rects[i].area() + MERGE_SLACK) {
+      rect = merged;
+      remove(i);
+      i = 0;
+    } else {
+      ++i;
+    }
+  }
+  if (_count == MAX_RECTS) {
+    uint8_t best = 0;
+    uint32_t waste = UINT32_MAX;
+
+    for (uint8_t i = 0; i < _count; ++i) {
+      uint32_t cost = rect.merge(_rects[i]).area() - _rects[i].area();
+
+      if (cost < waste) {
+        waste = cost;
+        best = i;
+      }
+    }
+    rect = rect.merge(_rects[best]);
+    remove(best);
+  }
+  _rects[_count++] = rect;
+}
+
+// Pushes dirty rectangles until `budget` pixels have gone out. A rectangle
+// that does not fit is sent in part, whole rows at a time, so a caller can
+// spread a large update across several passes of the main loop. Returns true
+// once the panel matches the buffer.
+template <class Display> bool FrameBuffer<Display>::flush(uint32_t budget) {
+  while (_count && budget) {
+    Rect &rect = _rects[_count - 1];
+    uint8_t w = rect.x1 - rect.x0 + 1;
+    uint32_t rows = rect.y1 - rect.y0 + 1;
+
+    if (rows * w > budget)
+      rows = budget / w ? budget / w : 1;
+    _display.draw(rect.x0, rect.y0, w, rows,
+                  &_pixels[rect.y0 * WIDTH + rect.x0], WIDTH);
+    budget = (rows * w < budget) ? budget - rows * w : 0;
+    if (rect.y0 + rows > rect.y1)
+      --_count;
+    else
+      rect.y0 += rows;
+  }
+  return !_count;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// A periodic deadline for cooperative loops. due() is true at most once per
+// period; if the loop falls more than a period behind, the missed ticks are
+// dropped rather than fired back to back.
+class Interval {
+public:
+  explicit Interval(uint32_t period, uint32_t now = 0)
+      : _period(period), _next(now) {}
+
+  bool due(uint32_t now);
+  void restart(uint32_t now) { _next = now + _period; }
+
+protected:
+  uint32_t _period;
+  uint32_t _next;
+};
+
+inline bool Interval::due(uint32_t now) {
+  if ((int32_t)(now - _next) < 0)
+    return false;
+  _next += _period;
+  if ((int32_t)(now - _next) >= 0)
+    _next = now + _period;
+  return true;
+}
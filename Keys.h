@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Debounces the five-way keypad. Pin interrupts only count that a key moved,
+// so a tap shorter than a loop pass is not lost; poll() then reports a change
+// on the first edge and ignores further edges for `lockout`, which bounds the
+// input latency to one poll interval instead of the bounce time. Each key's
+// count is written by its ISR alone and poll() compares it with the last one
+// it saw, so there is no atomic read-modify-write on the C3.
+class Keys {
+public:
+  enum Key : uint8_t { UP, RIGHT, DOWN, LEFT, CENTRE, COUNT };
+
+  struct Event {
+    Key key;
+    bool pressed;
+  };
+
+  explicit Keys(uint32_t lockout) : _lockout(lockout) {}
+
+  void latch(Key key) {
+    _moves[key].store(_moves[key].load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+  }
+  void poll(uint32_t now, uint8_t pressed);
+  bool pop(Event &event);
+
+  bool pressed(Key key) const { return _stable & (1 << key); }
+
+protected:
+  static const uint8_t EVENTS = 8;
+
+  void push(Key key, bool pressed);
+
+  uint32_t _lockout;
+  std::atomic<uint32_t> _moves[COUNT] = {};
+  uint32_t _seen[COUNT] = {};
+  uint8_t _stable = 0;
+  uint32_t _changed[COUNT] = {};
+  Event _events[EVENTS];
+  uint8_t _head = 0;
+  uint8_t _count = 0;
+};
+
+// `pressed` has bit n set while key n is held down right now.
+inline void Keys::poll(uint32_t now, uint8_t pressed) {
+  for (uint8_t i = 0; i < COUNT; ++i) {
+    uint8_t bit = 1 << i;
+    uint32_t moves = _moves[i].load(std::memory_order_relaxed);
+    bool moved = moves != _seen[i];
+
+    _seen[i] = moves;
+
+    if (now - _changed[i] < _lockout)
+      continue;
+    if ((pressed ^ _stable) & bit) {
+      _stable ^= bit;
+      _changed[i] = now;
+      push((Key)i, _stable & bit);
+    } else if (moved && !(_stable & bit)) {
+      // Pressed and released again between two polls.
+      _changed[i] = now;
+      push((Key)i, true);
+      push((Key)i, false);
+    }
+  }
+}
+
+inline bool Keys::pop(Event &event) {
+  if (!_count)
+    return false;
+  event = _events[_head];
+  _head = (_head + 1) % EVENTS;
+  --_count;
+  return true;
+}
+
+inline void Keys::push(Key key, bool pressed) {
+  if (_count < EVENTS) {
+    _events[(_head + _count) % EVENTS] = {key, pressed};
+    ++_count;
+  }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+
+// What a sampled light pulse looked like. Levels are raw ADC counts and
+// durations are in samples.
+struct ProfileResult {
+  uint16_t baseline;
+  uint16_t peak;
+  uint32_t samples;  // trigger crossing to trigger crossing
+  float half;        // time above 50% of the peak over baseline
+  float effective;   // integral / (peak - baseline): equivalent square pulse
+  uint32_t integral; // sum of (sample - baseline) over the pulse
+};
+
+// Measures light pulses from a stream of ADC samples handed over in chunks of
+// any size, with fixed storage and constant work per sample. The baseline is
+// tracked while idle; a pulse starts when a sample rises `trigger` counts
+// above it and ends after `holdoff` samples back below. The 50% width cannot
+// be known until the peak is, so instead of buffering the pulse the samples
+// are binned by level and the width is read off the histogram at the end.
+class LightProfile {
+public:
+  static const uint8_t BITS = 12;
+  static const uint8_t BINS = 128;
+
+  LightProfile(uint16_t trigger, uint16_t holdoff)
+      : _trigger(trigger), _holdoff(holdoff) {}
+
+  uint32_t feed(const uint16_t *samples, uint32_t count);
+  bool pop(ProfileResult &result);
+
+  // E.g. the adaptive level from FlickerFilter; set it between pulses.
+  void trigger(uint16_t trigger) { _trigger = trigger; }
+  uint16_t baseline() const { return _baseline >> BASELINE_SHIFT; }
+  bool active() const { return _active; }
+  void reset();
+
+protected:
+  static const uint8_t BASELINE_SHIFT = 6;
+  static const uint8_t BIN_SHIFT = BITS - 7;
+  static_assert((1 << BITS) >> BIN_SHIFT == BINS,
+                "BIN_SHIFT must match BINS");
+
+  void finish();
+
+  uint16_t _trigger;
+  uint16_t _holdoff;
+  uint32_t _baseline = 0; // fixed point, BASELINE_SHIFT fraction bits
+  bool _primed = false;
+  bool _active = false;
+  bool _ready = false;
+  uint16_t _below = 0;
+  uint16_t _peak = 0;
+  uint32_t _samples = 0;
+  uint32_t _integral = 0;
+  uint32_t _bins[BINS];
+  ProfileResult _result;
+};
+
+inline void LightProfile::reset() {
+  _primed = false;
+  _active = false;
+  _ready = false;
+}
+
+// Consumes samples until a pulse completes or the chunk runs out and returns
+// how many were used, so the caller can pop() the result and feed the rest.
+inline uint32_t LightProfile::feed(const uint16_t *samples, uint32_t count) {
+  uint16_t base = _baseline >> BASELINE_SHIFT;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t sample = samples[i] & ((1 << BITS) - 1);
+
+    if (!_primed) {
+      _baseline = (uint32_t)sample << BASELINE_SHIFT;
+      base = sample;
+      _primed = true;
+    }
+    if (!_active) {
+      if (sample > base + _trigger) {
+        _active = true;
+        _below = 0;
+        _peak = sample;
+        _samples = 0;
+        _integral = 0;
+        for (uint32_t &bin : _bins)
+          bin = 0;
+      } else {
+        // Exponential moving average with a 2^BASELINE_SHIFT sample time
+        // constant.
+        _baseline += sample - (_baseline >> BASELINE_SHIFT);
+        base = _baseline >> BASELINE_SHIFT;
+        continue;
+      }
+    }
+    ++_samples;
+    ++_bins[sample >> BIN_SHIFT];
+    if (sample > _peak)
+      _peak = sample;
+    if (sample > base)
+      _integral += sample - base;
+    if (sample > base + _trigger) {
+      _below = 0;
+    } else if (++_below >= _holdoff) {
+      _samples -= _below;
+      finish();
+      return i + 1;
+    }
+  }
+  return count;
+}
+
+inline bool LightProfile::pop(ProfileResult &result) {
+  if (!_ready)
+    return false;
+  result = _result;
+  _ready = false;
+  return true;
+}
+
+// Counts the samples above the 50% level: whole bins above it, plus the share
+// of the bin it falls in, assuming samples spread evenly within a bin.
+inline void LightProfile::finish() {
+  uint16_t base = _baseline >> BASELINE_SHIFT;
+  uint16_t level = base + (_peak - base) / 2;
+  uint8_t threshold = level >> BIN_SHIFT;
+  float half = 0;
+
+  for (uint8_t i = threshold + 1; i < BINS; ++i)
+    half += _bins[i];
+  half += _bins[threshold] *
+          (float)(((threshold + 1) << BIN_SHIFT) - level) / (1 << BIN_SHIFT);
+
+  _result.baseline = base;
+  _result.peak = _peak;
+  _result.samples = _samples;
+  _result.half = half;
+  _result.effective = _peak > base ? (float)_integral / (_peak - base) : 0;
+  _result.integral = _integral;
+  _active = false;
+  _ready = true;
+}
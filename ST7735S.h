@@ -3,8 +3,24 @@
 #include <Arduino.h>
 #include <SPI.h>
 
+// Stream pixels with the SPIClass block writes rather than one transfer16()
+// per pixel. Both paths put the same bytes on the wire.
+#ifndef ST7735S_BULK
+#define ST7735S_BULK 1
+#endif
+
+// Run the panel in 12 bit colour (RGB444, COLMOD 3): two pixels in three
+// bytes instead of four. Colours stay RGB565 in the API and are reduced on
+// the way out.
+#ifndef ST7735S_RGB444
+#define ST7735S_RGB444 0
+#endif
+
+// Pins, bus and clock are fixed at compile time. BL_PIN, if given, drives the
+// backlight, which stays dark until the first frame has been written.
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI = SPI>
+          SPIClass &_SPI = SPI, const uint32_t FREQUENCY = 20000000,
+          const int8_t BL_PIN = -1>
 class ST7735S {
 public:
   static const uint16_t BLACK = 0x0000;
@@ -15,22 +31,37 @@ public:
   static const uint16_t BLUE = 0x001F;
   static const uint16_t YELLOW = 0xFFE0;
 
+  static const uint8_t WIDTH = 160;
+  static const uint8_t HEIGHT = 80;
+  static const uint8_t FONT_WIDTH = 7;
+  static const uint8_t FONT_HEIGHT = 16;
+  static const uint8_t FONT_GAP = 1;
+
   void begin();
   void reset();
 
-  uint8_t width() const { return 160; }
-  uint8_t height() const { return 80; }
+  uint8_t width() const { return WIDTH; }
+  uint8_t height() const { return HEIGHT; }
 
   uint16_t rgb(uint8_t r, uint8_t g, uint8_t b) const;
+  static uint16_t rgb444(uint16_t c) {
+    return ((c >> 12) << 8) | (((c >> 7) & 0x0F) << 4) | ((c >> 1) & 0x0F);
+  }
   void fill(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t c);
   void clear() { fill(0, 0, width(), height(), 0); }
   void pixel(uint8_t x, uint8_t y, uint16_t c) { fill(x, y, 1, 1, c); }
-  void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *data);
+  void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+            const uint16_t *data) {
+    draw(x, y, w, h, data, w);
+  }
+  void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *data,
+            uint16_t stride);
   void draw(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t *bits,
             uint16_t cf, uint16_t cb = BLACK);
 
   uint8_t charWidth() const { return FONT_WIDTH + FONT_GAP; }
   uint8_t charHeight() const { return FONT_HEIGHT; }
+  static const uint8_t *glyph(char c);
 
   void print(uint8_t x, uint8_t y, char c, uint16_t cf, uint16_t cb = BLACK);
   void print(uint8_t x, uint8_t y, const char *str, uint16_t cf,
@@ -40,27 +71,66 @@ public:
   void inverse(bool on);
   void power(bool on);
 
+  // Hardware scrolling. In landscape the controller's vertical scroll runs
+  // along x: columns [x, x + w) become a ring and scroll(offset) shows the
+  // column drawn at x + offset at the left edge, at the cost of one command.
+  // Columns outside the area stay put. reset() and scrollOff() return to
+  // normal display mode; scroll() does nothing until the next scrollArea().
+  void scrollArea(uint8_t x, uint8_t w);
+  void scroll(uint8_t offset);
+  void scrollOff();
+
 protected:
-  static const uint8_t FONT_WIDTH = 7;
-  static const uint8_t FONT_HEIGHT = 16;
-  static const uint8_t FONT_GAP = 1;
+  static const uint8_t BULK_PIXELS = 64;
+  // The 0.96" 160x80 module (TFT_eSPI's GREENTAB160x80) shows the middle of
+  // the 132x162 frame memory: rows 1-160 and columns 26-105, which are x and y
+  // in landscape. Its glass is built inverted, so INVON gives true colours,
+  // and its filters are BGR, hence MADCTL bit 3.
+  static const uint8_t COL_START = 1;
+  static const uint8_t ROW_START = 26;
+  static const uint8_t LINES = 162; // frame memory rows, x in landscape
 
   void sendStart();
   void sendEnd();
   void sendCmd(uint8_t cmd);
   void sendCmd(uint8_t cmd, uint8_t arg);
   void sendCmd(uint8_t cmd, const uint8_t *args, uint16_t count);
+  void writeCmd(uint8_t cmd, const uint8_t *args = nullptr,
+                uint16_t count = 0);
   void sendData(const uint8_t *data, uint16_t count);
   void sendData(const uint16_t *data, uint16_t count);
   void sendData(uint8_t data, uint16_t count);
   void sendData(uint16_t data, uint16_t count);
 
+#if ST7735S_RGB444
+  void pack(uint16_t c, uint8_t *&out);
+#endif
+
   void select(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+  uint8_t scrollTop() const {
+    return _flipped ? LINES - COL_START - _scrollX - _scrollW
+                    : COL_START + _scrollX;
+  }
+  void invalidate() { _cols = _rows = INVALID; }
+
+  static const uint16_t INVALID = 0xFFFF;
+
+  uint16_t _cols = INVALID;
+  uint16_t _rows = INVALID;
+  bool _flipped = false;
+  uint8_t _scrollX = 0;
+  uint8_t _scrollW = 0;
+#if ST7735S_RGB444
+  // A window with an odd pixel count so far ends half way through a byte;
+  // the last pixel's blue nibble waits here for the next pixel or sendEnd().
+  bool _half = false;
+  uint8_t _nibble = 0;
+#endif
 };
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::begin() {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::begin() {
   if (CS_PIN >= 0) {
     pinMode(CS_PIN, OUTPUT);
     digitalWrite(CS_PIN, HIGH);
@@ -69,15 +139,25 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::begin() {
   if (RST_PIN >= 0) {
     pinMode(RST_PIN, OUTPUT);
   }
+  if (BL_PIN >= 0) {
+    pinMode(BL_PIN, OUTPUT);
+    digitalWrite(BL_PIN, LOW);
+  }
 
   _SPI.begin();
 
   reset();
+
+  if (BL_PIN >= 0)
+    digitalWrite(BL_PIN, HIGH);
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::reset() {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::reset() {
+  invalidate();
+  _flipped = false;
+  _scrollW = 0;
   if (RST_PIN >= 0) {
     digitalWrite(RST_PIN, LOW);
     delay(100);
@@ -91,9 +171,10 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::reset() {
   sendCmd(0x11); // SLPOUT
   delay(120);
 
-  sendCmd(0x36, 0x68); // MADCTL
-  sendCmd(0x3A, 5);    // COLMOD (16 bit)
-  sendCmd(0x13);       // NORON
+  sendCmd(0x36, 0x68); // MADCTL: MX, MV, BGR
+  sendCmd(0x3A, ST7735S_RGB444 ? 3 : 5); // COLMOD (12 or 16 bit)
+  sendCmd(0x21);       // INVON, see COL_START
+  sendCmd(0x13);       // NORON, also leaves scroll mode
 
   clear();
 
@@ -101,9 +182,9 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::reset() {
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-uint16_t ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::rgb(uint8_t r, uint8_t g,
-                                                     uint8_t b) const {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+uint16_t ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::rgb(
+    uint8_t r, uint8_t g, uint8_t b) const {
   uint16_t result;
 
   result = (r >> 3) << 11;
@@ -113,10 +194,9 @@ uint16_t ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::rgb(uint8_t r, uint8_t g,
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::fill(uint8_t x, uint8_t y,
-                                                  uint8_t w, uint8_t h,
-                                                  uint16_t c) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::fill(
+    uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t c) {
   if ((x < width()) && (y < height())) {
     if (x + w > width())
       w = width() - x;
@@ -124,14 +204,15 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::fill(uint8_t x, uint8_t y,
       h = height() - y;
     select(x, y, w, h);
     sendData(c, w * h);
+    sendEnd();
   }
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::draw(uint8_t x, uint8_t y,
-                                                  uint8_t w, uint8_t h,
-                                                  const uint16_t *data) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::draw(
+    uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *data,
+    uint16_t stride) {
   if ((x < width()) && (y < height())) {
     uint8_t _w, _h;
 
@@ -146,17 +227,17 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::draw(uint8_t x, uint8_t y,
     select(x, y, _w, _h);
     while (_h--) {
       sendData(data, _w);
-      data += w;
+      data += stride;
     }
+    sendEnd();
   }
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::draw(uint8_t x, uint8_t y,
-                                                  uint8_t w, uint8_t h,
-                                                  const uint8_t *bits,
-                                                  uint16_t cf, uint16_t cb) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::draw(
+    uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t *bits,
+    uint16_t cf, uint16_t cb) {
   if ((x < width()) && (y < height())) {
     uint16_t line[w];
     uint8_t _w, _h;
@@ -169,20 +250,23 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::draw(uint8_t x, uint8_t y,
       _h = height() - y;
     else
       _h = h;
+    select(x, y, _w, _h);
     for (uint8_t _y = 0; _y < _h; ++_y) {
       for (uint8_t _x = 0; _x < _w; ++_x) {
         line[_x] = (bits[(_y / 8) * w + _x] & (1 << (_y % 8))) ? cf : cb;
       }
-      select(x, y + _y, _w, 1);
       sendData(line, _w);
     }
+    sendEnd();
   }
 }
 
+// Column-major 7x16 font from ' ' onwards; each glyph is FONT_WIDTH bytes of
+// the top 8 rows followed by FONT_WIDTH bytes of the bottom 8.
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::print(uint8_t x, uint8_t y, char c,
-                                                   uint16_t cf, uint16_t cb) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+const uint8_t *ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::glyph(
+    char c) {
   static const uint8_t FONT[] = {
       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
       0x00, 0x00, 0x00, 0x00, 0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -296,67 +380,167 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::print(uint8_t x, uint8_t y, char c,
       0x00, 0x00, 0x40, 0x3E, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01,
       0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-  draw(x, y, FONT_WIDTH, FONT_HEIGHT,
-       &FONT[(c - ' ') * FONT_WIDTH * ((FONT_HEIGHT + 7) / 8)], cf, cb);
-  fill(x + FONT_WIDTH, y, FONT_GAP, FONT_HEIGHT, cb);
+  return &FONT[(c - ' ') * FONT_WIDTH * ((FONT_HEIGHT + 7) / 8)];
+}
+
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::print(
+    uint8_t x, uint8_t y, char c, uint16_t cf, uint16_t cb) {
+  const char str[] = {c, 0};
+
+  print(x, y, str, cf, cb);
 }
 
+// The whole run of characters, gap columns included, goes out as a single
+// window and RAMWR burst, expanded one panel row at a time.
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::print(uint8_t x, uint8_t y,
-                                                   const char *str, uint16_t cf,
-                                                   uint16_t cb) {
-  while (*str && (x < width())) {
-    print(x, y, *str++, cf, cb);
-    x += FONT_WIDTH + FONT_GAP;
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::print(
+    uint8_t x, uint8_t y, const char *str, uint16_t cf, uint16_t cb) {
+  if ((x < width()) && (y < height())) {
+    uint16_t line[width()];
+    uint8_t _w = 0, _h;
+    uint8_t n = 0;
+
+    while (str[n] && (x + _w < width())) {
+      _w += charWidth();
+      ++n;
+    }
+    if (!n)
+      return;
+    if (x + _w > width())
+      _w = width() - x;
+    if (y + FONT_HEIGHT > height())
+      _h = height() - y;
+    else
+      _h = FONT_HEIGHT;
+    select(x, y, _w, _h);
+    for (uint8_t _y = 0; _y < _h; ++_y) {
+      uint16_t row = (_y / 8) * FONT_WIDTH;
+      uint8_t mask = 1 << (_y % 8);
+      uint8_t _x = 0;
+
+      for (uint8_t i = 0; i < n; ++i) {
+        const uint8_t *bits = glyph(str[i]) + row;
+
+        for (uint8_t col = 0; (col < FONT_WIDTH) && (_x < _w); ++col) {
+          line[_x++] = (bits[col] & mask) ? cf : cb;
+        }
+        for (uint8_t col = 0; (col < FONT_GAP) && (_x < _w); ++col) {
+          line[_x++] = cb;
+        }
+      }
+      sendData(line, _w);
+    }
+    sendEnd();
   }
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-inline void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::flip(bool on) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+inline void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::flip(
+    bool on) {
   sendCmd(0x36, on ? 0xA8 : 0x68); // MADCTL
+  _flipped = on;
+  if (_scrollW)
+    scrollArea(_scrollX, _scrollW);
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-inline void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::inverse(bool on) {
-  sendCmd(0x20 | on); // INVOFF/INVON
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+inline void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::inverse(
+    bool on) {
+  sendCmd(on ? 0x20 : 0x21); // INVOFF/INVON, the panel is inverted
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::power(bool on) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::power(bool on) {
   if (on) {
     sendCmd(0x11); // SLPOUT
     delay(120);
     sendCmd(0x29); // DISPON
+    if (BL_PIN >= 0)
+      digitalWrite(BL_PIN, HIGH);
   } else {
+    if (BL_PIN >= 0)
+      digitalWrite(BL_PIN, LOW);
     sendCmd(0x28); // DISPOFF
     sendCmd(0x10); // SLPIN
     delay(120);
   }
 }
 
+// Flipping sets MY, which mirrors x onto the frame memory rows, so the
+// area is mirrored too and the scroll runs the other way round the ring.
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::scrollArea(
+    uint8_t x, uint8_t w) {
+  uint8_t args[6];
+
+  _scrollX = x;
+  _scrollW = w;
+  args[0] = 0;
+  args[1] = scrollTop();
+  args[2] = 0;
+  args[3] = w;
+  args[4] = 0;
+  args[5] = LINES - args[1] - w;
+  sendCmd(0x33, args, sizeof(args)); // VSCRDEF
+  scroll(0);
+}
+
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendStart() {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::scroll(
+    uint8_t offset) {
+  uint8_t args[2];
+
+  if (!_scrollW)
+    return;
+  offset %= _scrollW;
+  if (_flipped && offset)
+    offset = _scrollW - offset;
+  args[0] = 0;
+  args[1] = scrollTop() + offset;
+  sendCmd(0x37, args, sizeof(args)); // VSCSAD
+}
+
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::scrollOff() {
+  sendCmd(0x13); // NORON
+  _scrollW = 0;
+}
+
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendStart() {
   if (CS_PIN >= 0)
     digitalWrite(CS_PIN, LOW);
-  _SPI.beginTransaction(SPISettings(20000000, MSBFIRST, SPI_MODE0));
+  _SPI.beginTransaction(SPISettings(FREQUENCY, MSBFIRST, SPI_MODE0));
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendEnd() {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendEnd() {
+#if ST7735S_RGB444
+  if (_half) {
+    _SPI.transfer(_nibble << 4);
+    _half = false;
+  }
+#endif
   _SPI.endTransaction();
   if (CS_PIN >= 0)
     digitalWrite(CS_PIN, HIGH);
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendCmd(uint8_t cmd) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendCmd(
+    uint8_t cmd) {
   sendStart();
   digitalWrite(DC_PIN, LOW);
   _SPI.transfer(cmd);
@@ -364,96 +548,183 @@ void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendCmd(uint8_t cmd) {
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendCmd(uint8_t cmd, uint8_t arg) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendCmd(
+    uint8_t cmd, uint8_t arg) {
   sendStart();
-  digitalWrite(DC_PIN, LOW);
-  _SPI.transfer(cmd);
-  digitalWrite(DC_PIN, HIGH);
-  _SPI.transfer(arg);
+  writeCmd(cmd, &arg, 1);
   sendEnd();
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendCmd(uint8_t cmd,
-                                                     const uint8_t *args,
-                                                     uint16_t count) {
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendCmd(
+    uint8_t cmd, const uint8_t *args, uint16_t count) {
   sendStart();
+  writeCmd(cmd, args, count);
+  sendEnd();
+}
+
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::writeCmd(
+    uint8_t cmd, const uint8_t *args, uint16_t count) {
   digitalWrite(DC_PIN, LOW);
   _SPI.transfer(cmd);
   digitalWrite(DC_PIN, HIGH);
   while (count--) {
     _SPI.transfer(*args++);
   }
-  sendEnd();
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-inline void
-ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendData(const uint8_t *data,
-                                                 uint16_t count) {
-  sendCmd(0x2C, data, count); // RAMWR
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendData(
+    const uint8_t *data, uint16_t count) {
+#if ST7735S_BULK
+  _SPI.writeBytes(data, count);
+#else
+  while (count--) {
+    _SPI.transfer(*data++);
+  }
+#endif
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendData(const uint16_t *data,
-                                                      uint16_t count) {
-  sendStart();
-  digitalWrite(DC_PIN, LOW);
-  _SPI.transfer(0x2C); // RAMWR
-  digitalWrite(DC_PIN, HIGH);
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendData(
+    const uint16_t *data, uint16_t count) {
+#if ST7735S_RGB444
+  uint8_t packed[BULK_PIXELS * 3 / 2 + 1];
+
+  while (count) {
+    uint16_t n = (count < BULK_PIXELS) ? count : BULK_PIXELS;
+    uint8_t *out = packed;
+
+    for (uint16_t i = 0; i < n; ++i)
+      pack(rgb444(data[i]), out);
+    sendData(packed, out - packed);
+    data += n;
+    count -= n;
+  }
+#elif ST7735S_BULK
+  _SPI.writePixels(data, count * sizeof(data[0]));
+#else
   while (count--) {
     _SPI.transfer16(*data++);
   }
-  sendEnd();
+#endif
 }
 
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendData(uint8_t data,
-                                                      uint16_t count) {
-  sendStart();
-  digitalWrite(DC_PIN, LOW);
-  _SPI.transfer(0x2C); // RAMWR
-  digitalWrite(DC_PIN, HIGH);
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendData(
+    uint8_t data, uint16_t count) {
+#if ST7735S_BULK
+  _SPI.writePattern(&data, 1, count);
+#else
   while (count--) {
     _SPI.transfer(data);
   }
-  sendEnd();
+#endif
 }
 
+// In bulk mode a short line of the colour is laid out in wire (big endian)
+// order once and clocked out repeatedly as a block.
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::sendData(uint16_t data,
-                                                      uint16_t count) {
-  sendStart();
-  digitalWrite(DC_PIN, LOW);
-  _SPI.transfer(0x2C); // RAMWR
-  digitalWrite(DC_PIN, HIGH);
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::sendData(
+    uint16_t data, uint16_t count) {
+#if ST7735S_RGB444
+  // Once on a byte boundary, a line of BULK_PIXELS (an even number) packs to
+  // the same bytes every time and can be sent repeatedly.
+  uint8_t packed[BULK_PIXELS * 3 / 2 + 1];
+  uint16_t c = rgb444(data);
+  uint8_t *out = packed;
+
+  if (_half && count) {
+    pack(c, out);
+    sendData(packed, out - packed);
+    --count;
+  }
+  if (count >= BULK_PIXELS) {
+    out = packed;
+    for (uint16_t i = 0; i < BULK_PIXELS; ++i)
+      pack(c, out);
+    while (count >= BULK_PIXELS) {
+      sendData(packed, out - packed);
+      count -= BULK_PIXELS;
+    }
+  }
+  if (count) {
+    out = packed;
+    for (uint16_t i = 0; i < count; ++i)
+      pack(c, out);
+    sendData(packed, out - packed);
+  }
+#elif ST7735S_BULK
+  uint8_t line[BULK_PIXELS * 2];
+  uint16_t n = (count < BULK_PIXELS) ? count : BULK_PIXELS;
+
+  for (uint16_t i = 0; i < n; ++i) {
+    line[i * 2] = data >> 8;
+    line[i * 2 + 1] = data;
+  }
+  while (count) {
+    n = (count < BULK_PIXELS) ? count : BULK_PIXELS;
+    _SPI.writeBytes(line, n * 2);
+    count -= n;
+  }
+#else
   while (count--) {
     _SPI.transfer16(data);
   }
-  sendEnd();
+#endif
 }
 
+#if ST7735S_RGB444
+// Pixels are streamed as nibbles R G B R G B ..., two to a byte.
 template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
-          SPIClass &_SPI>
-void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI>::select(uint8_t x, uint8_t y,
-                                                    uint8_t w, uint8_t h) {
-  constexpr uint8_t COL_START = 0;
-  constexpr uint8_t ROW_START = 24;
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+inline void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::pack(
+    uint16_t c, uint8_t *&out) {
+  if (_half) {
+    *out++ = (_nibble << 4) | (c >> 8);
+    *out++ = c;
+    _half = false;
+  } else {
+    *out++ = c >> 4;
+    _nibble = c & 0x0F;
+    _half = true;
+  }
+}
+#endif
 
+// Opens a transaction, points the controller at the window and issues RAMWR,
+// leaving CS asserted so the caller can stream pixels and then sendEnd().
+// CASET/RASET are only resent when they differ from the last window.
+template <const uint8_t DC_PIN, const int8_t CS_PIN, const int8_t RST_PIN,
+          SPIClass &_SPI, const uint32_t FREQUENCY, const int8_t BL_PIN>
+void ST7735S<DC_PIN, CS_PIN, RST_PIN, _SPI, FREQUENCY, BL_PIN>::select(
+    uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
   uint8_t args[4];
+  uint16_t cols = ((COL_START + x) << 8) | (COL_START + x + w - 1);
+  uint16_t rows = ((ROW_START + y) << 8) | (ROW_START + y + h - 1);
 
+  sendStart();
   args[0] = 0;
-  args[1] = COL_START + x;
   args[2] = 0;
-  args[3] = COL_START + x + w - 1;
-  sendCmd(0x2A, args, sizeof(args) / sizeof(args[0])); // CASET
-  args[1] = ROW_START + y;
-  args[3] = ROW_START + y + h - 1;
-  sendCmd(0x2B, args, sizeof(args) / sizeof(args[0])); // RASET
+  if (cols != _cols) {
+    args[1] = cols >> 8;
+    args[3] = cols;
+    writeCmd(0x2A, args, sizeof(args) / sizeof(args[0])); // CASET
+    _cols = cols;
+  }
+  if (rows != _rows) {
+    args[1] = rows >> 8;
+    args[3] = rows;
+    writeCmd(0x2B, args, sizeof(args) / sizeof(args[0])); // RASET
+    _rows = rows;
+  }
+  writeCmd(0x2C); // RAMWR
 }
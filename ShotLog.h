@@ -0,0 +1,290 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Curtain.h"
+#include "Telemetry.h"
+
+// A session as found in the log: the marker's address and the tick rate the
+// shots in it were timed with.
+struct LogSession {
+  uint32_t number;
+  uint32_t address;
+  uint32_t ticksPerUs;
+};
+
+// Append-only shot history on raw NOR flash. The partition is a ring of
+// sectors used strictly in turn, so every sector is erased equally often;
+// when the log wraps the oldest sector is erased and its shots are lost.
+// Every entry is one 32 byte slot written once and checked by CRC, so a
+// write cut short by power loss is recognised and skipped on the next mount.
+//
+// Each sector starts with a header holding its sequence number and the
+// address of the newest session marker at the time, and each session marker
+// points back to the one before. Mounting reads one header per sector plus
+// the newest sector; listing sessions follows the chain.
+//
+// `Flash` provides SECTOR, size(), read(), write() and erase(); see
+// EspFlash.h and host/FileFlash.h. Programming may only clear bits.
+template <class Flash> class ShotLog {
+public:
+  static const uint32_t RECORD = 32;
+  static const uint32_t NONE = 0xFFFFFFFF;
+
+  explicit ShotLog(Flash &flash) : _flash(flash) {}
+
+  bool mount();
+  bool format();
+
+  bool session(uint32_t ticksPerUs);
+  bool append(const ShotRecord &record);
+
+  // Newest first.
+  uint32_t sessions(LogSession *sessions, uint32_t max);
+  // Calls visit(const ShotRecord &) for each shot still held for the session
+  // and returns how many there were.
+  template <typename F> uint32_t shots(const LogSession &session, F visit);
+
+  uint32_t current() const { return _session; }
+
+protected:
+  static const uint32_t SLOTS = Flash::SECTOR / RECORD;
+  static const uint32_t MAGIC = 0x53484C47;
+
+  enum Type : uint8_t { HEADER = 0x48, SESSION = 0x53, SHOT = 0x54 };
+
+  // HEADER: a = {sequence, newest session marker, MAGIC}
+  // SESSION: a = {previous session marker, ticks per us}
+  // SHOT: a = {open[1] - open[0], open[2] - open[0], width[0..2]}
+  struct Entry {
+    uint8_t type;
+    uint8_t channels;
+    uint8_t mask;
+    uint8_t reserved;
+    uint32_t number; // session
+    uint32_t a[5];
+    uint16_t spare;
+    uint16_t crc;
+  };
+  static_assert(sizeof(Entry) == RECORD, "Entry must fill one slot");
+
+  static bool erased(const Entry &entry);
+  static bool valid(const Entry &entry);
+  bool header(uint32_t sector, Entry &entry);
+  bool write(Entry &entry);
+  bool advance();
+
+  Flash &_flash;
+  uint32_t _sectors = 0;
+  uint32_t _sector = 0; // newest
+  uint32_t _sequence = 0;
+  uint32_t _slot = SLOTS;
+  uint32_t _session = 0;
+  uint32_t _last = NONE; // newest session marker
+};
+
+template <class Flash> bool ShotLog<Flash>::erased(const Entry &entry) {
+  const uint8_t *bytes = (const uint8_t *)&entry;
+
+  for (uint32_t i = 0; i < RECORD; ++i) {
+    if (bytes[i] != 0xFF)
+      return false;
+  }
+  return true;
+}
+
+template <class Flash> bool ShotLog<Flash>::valid(const Entry &entry) {
+  return ((entry.type == HEADER) || (entry.type == SESSION) ||
+          (entry.type == SHOT)) &&
+         (entry.crc ==
+          Telemetry::crc16((const uint8_t *)&entry, offsetof(Entry, crc)));
+}
+
+template <class Flash>
+bool ShotLog<Flash>::header(uint32_t sector, Entry &entry) {
+  return _flash.read(sector * Flash::SECTOR, &entry, RECORD) &&
+         valid(entry) && (entry.type == HEADER) && (entry.a[2] == MAGIC);
+}
+
+// Finds the newest sector by header sequence, then the first free slot and
+// the newest session marker within it.
+template <class Flash> bool ShotLog<Flash>::mount() {
+  Entry entry;
+  bool found = false;
+
+  _sectors = _flash.size() / Flash::SECTOR;
+  for (uint32_t i = 0; i < _sectors; ++i) {
+    if (header(i, entry) &&
+        (!found || ((int32_t)(entry.a[0] - _sequence) > 0))) {
+      found = true;
+      _sector = i;
+      _sequence = entry.a[0];
+      _session = entry.number;
+      _last = entry.a[1];
+    }
+  }
+  if (!found)
+    return format();
+
+  _slot = 1;
+  for (uint32_t i = 1; i < SLOTS; ++i) {
+    uint32_t address = _sector * Flash::SECTOR + i * RECORD;
+
+    if (!_flash.read(address, &entry, RECORD))
+      return false;
+    if (erased(entry))
+      continue;
+    _slot = i + 1;
+    if (valid(entry) && (entry.type == SESSION)) {
+      _session = entry.number;
+      _last = address;
+    }
+  }
+  return true;
+}
+
+// Erases the whole partition, which takes a while on the device; mount()
+// only does this when it finds no log at all.
+template <class Flash> bool ShotLog<Flash>::format() {
+  _sectors = _flash.size() / Flash::SECTOR;
+  if (_sectors < 2)
+    return false;
+  for (uint32_t i = 1; i < _sectors; ++i) {
+    if (!_flash.erase(i * Flash::SECTOR))
+      return false;
+  }
+  _sector = 0;
+  _sequence = 0;
+  _session = 0;
+  _last = NONE;
+  return advance();
+}
+
+// Moves on to the next sector in the ring, erasing whatever it held.
+template <class Flash> bool ShotLog<Flash>::advance() {
+  uint32_t next = _sequence ? (_sector + 1) % _sectors : 0;
+  Entry entry = {};
+
+  if (!_flash.erase(next * Flash::SECTOR))
+    return false;
+  entry.type = HEADER;
+  entry.number = _session;
+  entry.a[0] = _sequence + 1;
+  entry.a[1] = _last;
+  entry.a[2] = MAGIC;
+  entry.crc = Telemetry::crc16((const uint8_t *)&entry, offsetof(Entry, crc));
+  if (!_flash.write(next * Flash::SECTOR, &entry, RECORD))
+    return false;
+  _sector = next;
+  _sequence = entry.a[0];
+  _slot = 1;
+  return true;
+}
+
+template <class Flash> bool ShotLog<Flash>::write(Entry &entry) {
+  if ((_slot >= SLOTS) && !advance())
+    return false;
+  entry.crc = Telemetry::crc16((const uint8_t *)&entry, offsetof(Entry, crc));
+  // The slot is used up even if the write fails part way.
+  return _flash.write(_sector * Flash::SECTOR + _slot++ * RECORD, &entry,
+                      RECORD);
+}
+
+template <class Flash> bool ShotLog<Flash>::session(uint32_t ticksPerUs) {
+  Entry entry = {};
+
+  entry.type = SESSION;
+  entry.number = _session + 1;
+  entry.a[0] = _last;
+  entry.a[1] = ticksPerUs;
+  if (!write(entry))
+    return false;
+  _session = entry.number;
+  _last = _sector * Flash::SECTOR + (_slot - 1) * RECORD;
+  return true;
+}
+
+template <class Flash> bool ShotLog<Flash>::append(const ShotRecord &record) {
+  Entry entry = {};
+
+  if (!_session)
+    return false;
+  entry.type = SHOT;
+  entry.channels = record.channels;
+  entry.mask = record.mask;
+  entry.number = _session;
+  entry.a[0] = record.open[1] - record.open[0];
+  entry.a[1] = record.open[2] - record.open[0];
+  for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i)
+    entry.a[2 + i] = record.width[i];
+  return write(entry);
+}
+
+// A marker is only trusted if it still carries the expected number; once the
+// ring has wrapped over it the chain simply ends.
+template <class Flash>
+uint32_t ShotLog<Flash>::sessions(LogSession *sessions, uint32_t max) {
+  uint32_t address = _last;
+  uint32_t number = _session;
+  uint32_t count = 0;
+  Entry entry;
+
+  while ((count < max) && (address != NONE)) {
+    if (!_flash.read(address, &entry, RECORD) || !valid(entry) ||
+        (entry.type != SESSION) || (entry.number != number))
+      break;
+    sessions[count++] = {number--, address, entry.a[1]};
+    address = entry.a[0];
+  }
+  return count;
+}
+
+// Walks forward from the marker until the next one or the end of the log,
+// following the ring only while sector sequence numbers are consecutive.
+template <class Flash>
+template <typename F>
+uint32_t ShotLog<Flash>::shots(const LogSession &session, F visit) {
+  uint32_t sector = session.address / Flash::SECTOR;
+  uint32_t slot = session.address % Flash::SECTOR / RECORD;
+  uint32_t sequence;
+  uint32_t count = 0;
+  Entry entry;
+
+  if (!header(sector, entry))
+    return 0;
+  sequence = entry.a[0];
+  for (;;) {
+    if (++slot >= SLOTS) {
+      if (sector == _sector)
+        break;
+      sector = (sector + 1) % _sectors;
+      if (!header(sector, entry) || (entry.a[0] != ++sequence))
+        break;
+      slot = 0;
+      continue;
+    }
+    if ((sector == _sector) && (slot >= _slot))
+      break;
+    if (!_flash.read(sector * Flash::SECTOR + slot * RECORD, &entry, RECORD))
+      break;
+    if (!valid(entry))
+      continue;
+    if (entry.type == SESSION)
+      break;
+    if ((entry.type == SHOT) && (entry.number == session.number)) {
+      ShotRecord record;
+
+      record.channels = entry.channels;
+      record.mask = entry.mask;
+      record.open[0] = 0;
+      record.open[1] = entry.a[0];
+      record.open[2] = entry.a[1];
+      for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i)
+        record.width[i] = entry.a[2 + i];
+      visit(record);
+      ++count;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Wait-free single producer / single consumer ring. push() and pop() finish in
+// a bounded number of steps and never take a lock, so the producer can be an
+// ISR and the consumer a task (or two tasks at different priorities). Each
+// side only writes its own index and the producer alone keeps the overrun
+// count, so there is no atomic read-modify-write; the ESP32-C3 core has no
+// atomic instructions. A push into a full ring is dropped and counted.
+template <typename T, const uint32_t SIZE> class SpscQueue {
+  static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+public:
+  bool push(const T &item);
+  bool pop(T &item);
+
+  uint32_t size() const;
+  bool empty() const { return !size(); }
+  uint32_t overruns() const {
+    return _overruns.load(std::memory_order_relaxed);
+  }
+
+protected:
+  // Producer and consumer indices live on separate cache lines so a host
+  // build with the two sides on different cores does not false-share.
+  alignas(64) std::atomic<uint32_t> _head{0};
+  uint32_t _tailCache = 0;
+  std::atomic<uint32_t> _overruns{0};
+  alignas(64) std::atomic<uint32_t> _tail{0};
+  uint32_t _headCache = 0;
+  alignas(64) T _items[SIZE];
+};
+
+template <typename T, const uint32_t SIZE>
+bool SpscQueue<T, SIZE>::push(const T &item) {
+  uint32_t head = _head.load(std::memory_order_relaxed);
+
+  if (head - _tailCache >= SIZE) {
+    _tailCache = _tail.load(std::memory_order_acquire);
+    if (head - _tailCache >= SIZE) {
+      _overruns.store(_overruns.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+      return false;
+    }
+  }
+  _items[head & (SIZE - 1)] = item;
+  _head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, const uint32_t SIZE>
+bool SpscQueue<T, SIZE>::pop(T &item) {
+  uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+  if (tail == _headCache) {
+    _headCache = _head.load(std::memory_order_acquire);
+    if (tail == _headCache)
+      return false;
+  }
+  item = _items[tail & (SIZE - 1)];
+  _tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, const uint32_t SIZE>
+uint32_t SpscQueue<T, SIZE>::size() const {
+  return _head.load(std::memory_order_acquire) -
+         _tail.load(std::memory_order_acquire);
+}
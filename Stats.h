@@ -0,0 +1,119 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Running statistics for a series of shots at one marked speed. Everything is
+// updated in O(1) per shot with fixed storage: Welford mean/variance, min/max
+// and a histogram of half-stop bins. Exposures are in microseconds.
+class ShotStats {
+public:
+  static const uint8_t BINS = 32;
+  static const int8_t BIN_LOG2_MIN = -14; // bin 0 starts at 2^-14 s (61 us)
+  static const uint8_t BINS_PER_STOP = 2;
+
+  explicit ShotStats(float nominal = 0) { reset(nominal); }
+
+  void reset(float nominal = 0);
+  void add(float us);
+
+  uint32_t count() const { return _count; }
+  float nominal() const { return _nominal; }
+  float mean() const { return _mean; }
+  float variance() const { return _count > 1 ? _m2 / (_count - 1) : 0; }
+  float stddev() const { return sqrtf(variance()); }
+  float min() const { return _min; }
+  float max() const { return _max; }
+
+  // Exposure error of the mean against the nominal speed, in EV stops.
+  // Positive means the shutter is slow (overexposing).
+  float stops() const { return stops(_mean); }
+  float stops(float us) const;
+
+  uint16_t bin(uint8_t i) const { return _bins[i]; }
+  static uint8_t binOf(float us);
+  static float binStart(uint8_t i);
+
+  // The marked speed closest to `us` on a log scale, 1/8000 s to 8 s, and
+  // the one `by` places slower (negative: faster) than that, held at the
+  // ends of the scale.
+  static float nearest(float us) { return step(us, 0); }
+  static float step(float us, int8_t by);
+
+protected:
+  uint32_t _count;
+  float _nominal;
+  double _mean;
+  double _m2;
+  float _min;
+  float _max;
+  uint16_t _bins[BINS];
+};
+
+inline void ShotStats::reset(float nominal) {
+  _count = 0;
+  _nominal = nominal;
+  _mean = 0;
+  _m2 = 0;
+  _min = INFINITY;
+  _max = 0;
+  for (uint8_t i = 0; i < BINS; ++i)
+    _bins[i] = 0;
+}
+
+inline void ShotStats::add(float us) {
+  double delta = us - _mean;
+
+  ++_count;
+  _mean += delta / _count;
+  _m2 += delta * (us - _mean);
+  if (us < _min)
+    _min = us;
+  if (us > _max)
+    _max = us;
+  if (_bins[binOf(us)] < UINT16_MAX)
+    ++_bins[binOf(us)];
+}
+
+inline float ShotStats::stops(float us) const {
+  return (_nominal > 0) && (us > 0) ? log2f(us / _nominal) : 0;
+}
+
+inline uint8_t ShotStats::binOf(float us) {
+  float bin = (log2f(us / 1000000.0f) - BIN_LOG2_MIN) * BINS_PER_STOP;
+
+  if (!(bin > 0))
+    return 0;
+  if (bin >= BINS - 1)
+    return BINS - 1;
+  return (uint8_t)bin;
+}
+
+inline float ShotStats::binStart(uint8_t i) {
+  return 1000000.0f * exp2f(BIN_LOG2_MIN + (float)i / BINS_PER_STOP);
+}
+
+inline float ShotStats::step(float us, int8_t by) {
+  static const float SPEEDS[] = {
+      1000000.0f / 8000, 1000000.0f / 4000, 1000000.0f / 2000,
+      1000000.0f / 1000, 1000000.0f / 500,  1000000.0f / 250,
+      1000000.0f / 125,  1000000.0f / 60,   1000000.0f / 30,
+      1000000.0f / 15,   1000000.0f / 8,    1000000.0f / 4,
+      1000000.0f / 2,    1000000.0f,        2000000.0f,
+      4000000.0f,        8000000.0f};
+  const int8_t COUNT = sizeof(SPEEDS) / sizeof(SPEEDS[0]);
+  int8_t best = 0;
+  float error = INFINITY;
+
+  for (int8_t i = 0; i < COUNT; ++i) {
+    float e = fabsf(log2f(us / SPEEDS[i]));
+
+    if (e < error) {
+      error = e;
+      best = i;
+    }
+  }
+  int16_t at = best + by;
+
+  return SPEEDS[at < 0 ? 0 : at >= COUNT ? COUNT - 1 : at];
+}
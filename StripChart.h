@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scrolling plot of the most recent values, newest on the right. The chart
+// owns the full height of columns [x, x + w) and uses the display's hardware
+// scroll, so adding a sample draws one new column of `h` pixels plus a
+// scroll command instead of redrawing the plot. Points are joined by
+// vertical runs so steps stay visible, and a dotted reference line marks the
+// value the series should sit on.
+template <class Display> class StripChart {
+public:
+  static const uint8_t MAX_HEIGHT = Display::HEIGHT;
+
+  StripChart(Display &display, uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+      : _display(display), _x(x), _y(y), _w(w), _h(h) {}
+
+  void colors(uint16_t line, uint16_t grid, uint16_t back) {
+    _line = line;
+    _grid = grid;
+    _back = back;
+  }
+  // Values outside [low, high] are clamped to the edges.
+  void range(float low, float high, float reference) {
+    _low = low;
+    _high = high;
+    _reference = reference;
+  }
+
+  void begin();
+  void add(float value);
+  void end() { _display.scrollOff(); }
+
+protected:
+  uint8_t row(float value) const;
+
+  Display &_display;
+  uint8_t _x, _y, _w, _h;
+  uint16_t _line = 0xFFFF;
+  uint16_t _grid = 0x38E7;
+  uint16_t _back = 0;
+  float _low = -1;
+  float _high = 1;
+  float _reference = 0;
+  uint8_t _next = 0; // column the next sample goes in
+  uint8_t _last = 0; // row of the previous sample
+  bool _empty = true;
+};
+
+// Blanks the columns, reference line included, and sets up the scroll area.
+template <class Display> void StripChart<Display>::begin() {
+  uint16_t dots[Display::WIDTH];
+
+  for (uint8_t i = 0; i < _w; ++i)
+    dots[i] = i & 1 ? _back : _grid;
+  _display.fill(_x, 0, _w, Display::HEIGHT, _back);
+  _display.draw(_x, _y + row(_reference), _w, 1, dots);
+  _display.scrollArea(_x, _w);
+  _next = 0;
+  _empty = true;
+}
+
+template <class Display> uint8_t StripChart<Display>::row(float value) const {
+  float t = (value - _low) / (_high - _low);
+
+  if (!(t > 0)) // also catches NaN
+    return _h - 1;
+  if (t >= 1)
+    return 0;
+  return (uint8_t)((_h - 1) * (1 - t) + 0.5f);
+}
+
+// Draws the sample into the oldest column, then scrolls it to the right edge.
+template <class Display> void StripChart<Display>::add(float value) {
+  uint16_t column[MAX_HEIGHT];
+  uint8_t current = row(value);
+  uint8_t from = _empty ? current : _last;
+  uint8_t top = from < current ? from : current;
+  uint8_t bottom = from < current ? current : from;
+
+  for (uint8_t i = 0; i < _h; ++i)
+    column[i] = (i >= top) && (i <= bottom) ? _line : _back;
+  if (!(_next & 1) && (column[row(_reference)] == _back))
+    column[row(_reference)] = _grid;
+  _display.draw(_x + _next, _y, 1, _h, column);
+
+  _last = current;
+  _empty = false;
+  _next = (_next + 1) % _w;
+  _display.scroll(_next);
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Capture.h"
+#include "Curtain.h"
+#include "Profile.h"
+
+// Binary record stream for test rigs. Each record is
+//
+//   type:u8 seq:u16 payload crc:u16
+//
+// little endian, CRC-16/CCITT-FALSE over everything before it, then COBS
+// encoded and terminated by a zero byte. A reader that joins mid-stream, or
+// sees text or line noise, resyncs at the next zero. The sequence number
+// makes dropped records visible.
+class Telemetry {
+public:
+  enum Type : uint8_t { INFO = 1, SHOT, PROFILE, EDGE };
+
+  static const uint8_t MAX_PAYLOAD = 32;
+  static const uint8_t MAX_RAW = 1 + 2 + MAX_PAYLOAD + 2;
+  static const uint8_t MAX_FRAME = MAX_RAW + MAX_RAW / 254 + 2;
+
+  static uint16_t crc16(const uint8_t *data, size_t count,
+                        uint16_t crc = 0xFFFF);
+  static size_t encode(const uint8_t *in, size_t count, uint8_t *out);
+  static size_t decode(const uint8_t *in, size_t count, uint8_t *out);
+
+  static uint8_t *put(uint8_t *p, uint16_t value);
+  static uint8_t *put(uint8_t *p, uint32_t value);
+  static uint8_t *put(uint8_t *p, float value);
+  static const uint8_t *get(const uint8_t *p, uint16_t &value);
+  static const uint8_t *get(const uint8_t *p, uint32_t &value);
+  static const uint8_t *get(const uint8_t *p, float &value);
+};
+
+struct TelemetryInfo {
+  uint32_t ticksPerUs;
+  uint32_t profileRate;
+};
+
+struct TelemetryRecord {
+  Telemetry::Type type;
+  uint16_t seq;
+  union {
+    TelemetryInfo info;
+    ShotRecord shot;
+    ProfileResult profile;
+    Edge edge;
+  };
+};
+
+// Queues encoded frames in a flat buffer that the caller drains as the port
+// accepts bytes, so a burst of shots never blocks on the UART. When the
+// buffer is full new records are dropped and counted; the gap shows up in
+// the sequence numbers on the other end.
+template <const size_t SIZE> class TelemetryWriter {
+public:
+  TelemetryWriter() { _buffer[_end++] = 0; }
+
+  bool info(const TelemetryInfo &info);
+  bool shot(const ShotRecord &record);
+  bool profile(const ProfileResult &result);
+  bool edge(const Edge &edge);
+
+  const uint8_t *data() const { return _buffer + _start; }
+  size_t pending() const { return _end - _start; }
+  void consume(size_t count) { _start += count; }
+
+  uint32_t dropped() const { return _dropped; }
+
+protected:
+  bool frame(Telemetry::Type type, const uint8_t *payload, uint8_t count);
+
+  uint8_t _buffer[SIZE];
+  size_t _start = 0;
+  size_t _end = 0;
+  uint16_t _seq = 0;
+  uint32_t _dropped = 0;
+};
+
+// Collects bytes up to each zero delimiter and turns valid frames back into
+// records. Frames that are too long, fail the CRC or have an unexpected
+// payload length are counted and skipped.
+class TelemetryReader {
+public:
+  bool feed(uint8_t byte, TelemetryRecord &record);
+
+  uint32_t errors() const { return _errors; }
+  uint32_t lost() const { return _lost; }
+
+protected:
+  bool parse(const uint8_t *raw, size_t count, TelemetryRecord &record);
+
+  uint8_t _frame[Telemetry::MAX_FRAME];
+  size_t _count = 0;
+  bool _overflow = false;
+  bool _synced = false;
+  uint16_t _next = 0;
+  uint32_t _errors = 0;
+  uint32_t _lost = 0;
+};
+
+inline uint16_t Telemetry::crc16(const uint8_t *data, size_t count,
+                                 uint16_t crc) {
+  while (count--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; ++i)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Consistent Overhead Byte Stuffing: removes every zero from the data at a
+// cost of one byte per 254. The delimiter is not written.
+inline size_t Telemetry::encode(const uint8_t *in, size_t count,
+                                uint8_t *out) {
+  size_t code = 0, length = 1;
+
+  out[code] = 1;
+  for (size_t i = 0; i < count; ++i) {
+    if (in[i]) {
+      out[length++] = in[i];
+      ++out[code];
+    }
+    if (!in[i] || (out[code] == 0xFF)) {
+      code = length++;
+      out[code] = 1;
+    }
+  }
+  return length;
+}
+
+inline size_t Telemetry::decode(const uint8_t *in, size_t count,
+                                uint8_t *out) {
+  size_t length = 0;
+
+  for (size_t i = 0; i < count;) {
+    uint8_t code = in[i++];
+
+    if (!code || (i + code - 1 > count))
+      return 0;
+    for (uint8_t j = 1; j < code; ++j)
+      out[length++] = in[i++];
+    if ((code != 0xFF) && (i < count))
+      out[length++] = 0;
+  }
+  return length;
+}
+
+inline uint8_t *Telemetry::put(uint8_t *p, uint16_t value) {
+  *p++ = value;
+  *p++ = value >> 8;
+  return p;
+}
+
+inline uint8_t *Telemetry::put(uint8_t *p, uint32_t value) {
+  p = put(p, (uint16_t)value);
+  return put(p, (uint16_t)(value >> 16));
+}
+
+inline uint8_t *Telemetry::put(uint8_t *p, float value) {
+  uint32_t bits;
+
+  memcpy(&bits, &value, sizeof(bits));
+  return put(p, bits);
+}
+
+inline const uint8_t *Telemetry::get(const uint8_t *p, uint16_t &value) {
+  value = p[0] | (p[1] << 8);
+  return p + 2;
+}
+
+inline const uint8_t *Telemetry::get(const uint8_t *p, uint32_t &value) {
+  uint16_t lo, hi;
+
+  p = get(p, lo);
+  p = get(p, hi);
+  value = lo | ((uint32_t)hi << 16);
+  return p;
+}
+
+inline const uint8_t *Telemetry::get(const uint8_t *p, float &value) {
+  uint32_t bits;
+
+  p = get(p, bits);
+  memcpy(&value, &bits, sizeof(value));
+  return p;
+}
+
+template <const size_t SIZE>
+bool TelemetryWriter<SIZE>::info(const TelemetryInfo &info) {
+  uint8_t payload[8], *p = payload;
+
+  p = Telemetry::put(p, info.ticksPerUs);
+  p = Telemetry::put(p, info.profileRate);
+  return frame(Telemetry::INFO, payload, p - payload);
+}
+
+template <const size_t SIZE>
+bool TelemetryWriter<SIZE>::shot(const ShotRecord &record) {
+  uint8_t payload[2 + 8 * ShotRecord::MAX_CHANNELS], *p = payload;
+
+  *p++ = record.channels;
+  *p++ = record.mask;
+  for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i) {
+    p = Telemetry::put(p, record.open[i]);
+    p = Telemetry::put(p, record.width[i]);
+  }
+  return frame(Telemetry::SHOT, payload, p - payload);
+}
+
+template <const size_t SIZE>
+bool TelemetryWriter<SIZE>::profile(const ProfileResult &result) {
+  uint8_t payload[20], *p = payload;
+
+  p = Telemetry::put(p, result.baseline);
+  p = Telemetry::put(p, result.peak);
+  p = Telemetry::put(p, result.samples);
+  p = Telemetry::put(p, result.half);
+  p = Telemetry::put(p, result.effective);
+  p = Telemetry::put(p, result.integral);
+  return frame(Telemetry::PROFILE, payload, p - payload);
+}
+
+template <const size_t SIZE>
+bool TelemetryWriter<SIZE>::edge(const Edge &edge) {
+  uint8_t payload[6], *p = payload;
+
+  p = Telemetry::put(p, edge.ticks);
+  *p++ = edge.channel;
+  *p++ = edge.level;
+  return frame(Telemetry::EDGE, payload, p - payload);
+}
+
+template <const size_t SIZE>
+bool TelemetryWriter<SIZE>::frame(Telemetry::Type type, const uint8_t *payload,
+                                  uint8_t count) {
+  uint8_t raw[Telemetry::MAX_RAW], *p = raw;
+
+  if (_end + Telemetry::MAX_FRAME > SIZE) {
+    memmove(_buffer, _buffer + _start, _end - _start);
+    _end -= _start;
+    _start = 0;
+    if (_end + Telemetry::MAX_FRAME > SIZE) {
+      ++_dropped;
+      ++_seq;
+      return false;
+    }
+  }
+  *p++ = type;
+  p = Telemetry::put(p, _seq++);
+  memcpy(p, payload, count);
+  p += count;
+  p = Telemetry::put(p, Telemetry::crc16(raw, p - raw));
+  _end += Telemetry::encode(raw, p - raw, _buffer + _end);
+  _buffer[_end++] = 0;
+  return true;
+}
+
+inline bool TelemetryReader::feed(uint8_t byte, TelemetryRecord &record) {
+  uint8_t raw[Telemetry::MAX_FRAME];
+  size_t count;
+
+  if (byte) {
+    if (_count < sizeof(_frame))
+      _frame[_count++] = byte;
+    else
+      _overflow = true;
+    return false;
+  }
+  count = _count;
+  _count = 0;
+  if (!count)
+    return false;
+  if (_overflow) {
+    _overflow = false;
+    ++_errors;
+    return false;
+  }
+  count = Telemetry::decode(_frame, count, raw);
+  if (!parse(raw, count, record)) {
+    ++_errors;
+    return false;
+  }
+  if (_synced)
+    _lost += (uint16_t)(record.seq - _next);
+  _synced = true;
+  _next = record.seq + 1;
+  return true;
+}
+
+inline bool TelemetryReader::parse(const uint8_t *raw, size_t count,
+                                   TelemetryRecord &record) {
+  const uint8_t *p = raw + 3;
+  size_t payload = count - 5;
+  uint16_t crc;
+
+  if (count < 5)
+    return false;
+  Telemetry::get(raw + count - 2, crc);
+  if (crc != Telemetry::crc16(raw, count - 2))
+    return false;
+  record.type = (Telemetry::Type)raw[0];
+  Telemetry::get(raw + 1, record.seq);
+
+  switch (record.type) {
+  case Telemetry::INFO:
+    if (payload != 8)
+      return false;
+    p = Telemetry::get(p, record.info.ticksPerUs);
+    p = Telemetry::get(p, record.info.profileRate);
+    return true;
+  case Telemetry::SHOT:
+    if (payload != 2 + 8 * ShotRecord::MAX_CHANNELS)
+      return false;
+    record.shot.channels = *p++;
+    record.shot.mask = *p++;
+    for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i) {
+      p = Telemetry::get(p, record.shot.open[i]);
+      p = Telemetry::get(p, record.shot.width[i]);
+    }
+    return true;
+  case Telemetry::PROFILE:
+    if (payload != 20)
+      return false;
+    p = Telemetry::get(p, record.profile.baseline);
+    p = Telemetry::get(p, record.profile.peak);
+    p = Telemetry::get(p, record.profile.samples);
+    p = Telemetry::get(p, record.profile.half);
+    p = Telemetry::get(p, record.profile.effective);
+    p = Telemetry::get(p, record.profile.integral);
+    return true;
+  case Telemetry::EDGE:
+    if (payload != 6)
+      return false;
+    p = Telemetry::get(p, record.edge.ticks);
+    record.edge.channel = *p++;
+    record.edge.level = *p++;
+    return true;
+  }
+  return false;
+}
@@ -4,33 +4,718 @@
 #define KEY_LEFT 5
 #define KEY_CENTRE 4
 
-#include <TFT_eSPI.h>
+// Sensors in the order the first curtain crosses them. With a single sensor
+// fitted the others simply never fire and each shot is reported with just
+// channel 0. Channel 2 is on GPIO 20, which is U0RXD, so Serial has to be the
+// USB CDC port (CDCOnBoot=cdc in the Makefile's FQBN), not UART0.
+#define SENSOR_CHANNELS 3
+#define SENSOR_GLITCH_US 20
+#define SENSOR_WINDOW_US 50000
+
+// The capture task sits above the Arduino loop task (priority 1), which does
+// all the drawing, so a slow SPI transfer can never hold up edge processing.
+#define CAPTURE_PRIORITY (configMAX_PRIORITIES - 2)
+#define CAPTURE_POLL_MS 5
+
+// Light profile mode samples the analogue photodiode amplifier output. The
+// C3 only has ADC on GPIO 0-4, and the others are taken, so it shares GPIO 1
+// with sensor channel 1, whose edge interrupt is detached while profiling.
+// The comparator and the amplifier must never both drive the pin: a jumper
+// or an SPDT analogue switch selects one, and channel 1 is unavailable while
+// it is on the amplifier. Any ADC pin that no sensor uses works here with no
+// switch.
+#define PROFILE_PIN 1
+#define PROFILE_TRIGGER 100 // ADC counts above baseline
+#define PROFILE_HOLDOFF_US 1000
+// Room light ripples at twice the mains frequency: 100 for 50Hz mains, 120
+// for 60Hz. The profile samples go through FlickerFilter first, which learns
+// and subtracts the ripple and raises the trigger above what is left; 0
+// feeds them straight in.
+#define FLICKER_HZ 100
+
+// With TELEMETRY set, Serial carries COBS framed binary records instead of
+// text; decode them with build/host/decode. TELEMETRY_EDGES adds every raw
+// sensor edge to the stream.
+#define TELEMETRY 0
+#define TELEMETRY_EDGES 0
+#define TELEMETRY_BUFFER 1024
+#if TELEMETRY_EDGES && !TELEMETRY
+#error "TELEMETRY_EDGES needs TELEMETRY"
+#endif
+
+// LEFT runs the latency calibration: an LED on CALIBRATION_PIN, placed to
+// light every sensor at once, is pulsed CALIBRATION_REPS times at each width
+// from 1/8000 up, and the fitted offsets are kept in NVS and taken out of
+// every shot from then on. A pin write that takes longer than
+// CALIBRATION_SLACK_US was interrupted and its pulse is not used. GPIO 21 is
+// U0TXD, free because Serial is the USB CDC port.
+#define CALIBRATION_PIN 21
+#define CALIBRATION_REPS 16
+#define CALIBRATION_SLACK_US 2
+#define CALIBRATION_TIMEOUT_MS 100
+
+// Shots are logged to the "spiffs" data partition; the newest sessions are
+// listed over Serial at startup. The sensor interrupts are not IRAM-safe, so
+// an edge during a flash operation is taken late; the capture task drops any
+// shot with an edge stamped during one or up to FLASH_SLACK_US after, rather
+// than report a wrong speed.
+#define HISTORY_SESSIONS 5
+#define FLASH_SLACK_US 50
+
+// Readout and statistics on the left. The columns from CHART_X on belong to
+// the strip chart, which scrolls them in hardware, so nothing else may draw
+// there.
+#define CHART_X 92
+#define CHART_EV 1.0f // chart range either side of the nominal speed
+
+// The marked speed shots are measured against at power-on, in microseconds.
+// The up and down keys step it through the marked speeds.
+#define START_SPEED_US (1000000.0f / 125)
+
+// With BENCH set, setup() times the Bench.h scenarios on the panel and prints
+// them over Serial before the splash. Compare a saved log against the device
+// baseline with make bench-device LOG=<log>.
+#define BENCH 0
+#if BENCH && TELEMETRY
+#error "BENCH prints text, which would break the TELEMETRY stream"
+#endif
+
+#define KEY_LOCKOUT_MS 30
+#define SPLASH_MS 1000
+#define REFRESH_MS 33
+
+#include <Preferences.h>
 #include <SPI.h>
 
-TFT_eSPI tft = TFT_eSPI();
+#include "AdcStream.h"
+#include "Bench.h"
+#include "Calibration.h"
+#include "BigReadout.h"
+#include "Capture.h"
+#include "Curtain.h"
+#include "EspFlash.h"
+#include "Flicker.h"
+#include "FrameBuffer.h"
+#include "Interval.h"
+#include "Keys.h"
+#include "Profile.h"
+#include "ST7735S.h"
+#include "ShotLog.h"
+#include "SpscQueue.h"
+#include "Stats.h"
+#include "StripChart.h"
+#include "Telemetry.h"
+#include "tft-setup.h"
+
+typedef ST7735S<TFT_DC, TFT_CS, TFT_RST, SPI, SPI_FREQUENCY, LCD_BL> Display;
+
+Display lcd;
+FrameBuffer<Display> fb(lcd);
+BigReadout<Display, 12, 28, 3> readout(lcd, 0, 4);
+StripChart<Display> chart(lcd, CHART_X, 8, Display::WIDTH - CHART_X, 64);
+
+constexpr uint8_t SENSOR_PINS[ShotRecord::MAX_CHANNELS] = {0, 1, 20};
+constexpr uint8_t KEY_PINS[Keys::COUNT] = {KEY_UP, KEY_RIGHT, KEY_DOWN,
+                                           KEY_LEFT, KEY_CENTRE};
+
+// Sensor ISRs -> capture task -> loop, one SPSC queue per hop.
+SpscQueue<Edge, 256> edges;
+SpscQueue<ShotRecord, 16> shots;
+TaskHandle_t captureTaskHandle;
+#if TELEMETRY_EDGES
+SpscQueue<Edge, 256> rawEdges;
+#endif
+
+// Owned by the capture task once it is running.
+CurtainCorrelator correlator(SENSOR_CHANNELS, 0, 0);
+// Written by the capture task only.
+std::atomic<uint32_t> stalledShots{0};
+
+// ADC -> profile task -> loop.
+SpscQueue<ProfileResult, 8> profiles;
+TaskHandle_t profileTaskHandle;
+std::atomic<bool> profiling{false};
+AdcStream adc;
+uint32_t profileRate;
+
+// Owned by the loop task.
+ShotStats stats(START_SPEED_US);
+ShotRecord lastShot;
+ProfileResult lastProfile;
+uint32_t ticksPerUs;
+#if TELEMETRY
+TelemetryWriter<TELEMETRY_BUFFER> telemetry;
+#endif
+EspFlash flash;
+ShotLog<EspFlash> shotLog(flash);
+bool logging = false;
+LatencyTable latency;
+
+Keys keys(KEY_LOCKOUT_MS);
+Interval refresh(REFRESH_MS);
+uint32_t splashUntil;
+bool splash = true;
+bool dirty = false;
+
+template <const uint8_t CHANNEL> void IRAM_ATTR onSensorEdge() {
+  BaseType_t woken = pdFALSE;
+
+  edges.push({ESP.getCycleCount(), CHANNEL,
+              (uint8_t)digitalRead(SENSOR_PINS[CHANNEL])});
+  vTaskNotifyGiveFromISR(captureTaskHandle, &woken);
+  if (woken)
+    portYIELD_FROM_ISR();
+}
+
+void (*const SENSOR_ISRS[ShotRecord::MAX_CHANNELS])() = {
+    onSensorEdge<0>, onSensorEdge<1>, onSensorEdge<2>};
+
+template <const Keys::Key KEY> void IRAM_ATTR onKey() { keys.latch(KEY); }
+
+void (*const KEY_ISRS[Keys::COUNT])() = {onKey<Keys::UP>, onKey<Keys::RIGHT>,
+                                         onKey<Keys::DOWN>, onKey<Keys::LEFT>,
+                                         onKey<Keys::CENTRE>};
+
+uint8_t readKeys() {
+  uint8_t pressed = 0;
+
+  for (uint8_t i = 0; i < Keys::COUNT; ++i) {
+    if (digitalRead(KEY_PINS[i]) == LOW)
+      pressed |= 1 << i;
+  }
+  return pressed;
+}
+
+// Whether an edge of `record` lies in [from, to]; `end` is set to its last.
+bool touches(const ShotRecord &record, uint32_t from, uint32_t to,
+             uint32_t &end) {
+  bool hit = false;
+
+  end = record.open[record.first()];
+  for (uint8_t i = 0; i < record.channels; ++i) {
+    if (!(record.mask & (1 << i)))
+      continue;
+
+    uint32_t open = record.open[i], close = open + record.width[i];
+
+    hit |= (open - from <= to - from) || (close - from <= to - from);
+    if ((int32_t)(close - end) > 0)
+      end = close;
+  }
+  return hit;
+}
+
+// Woken by the sensor ISRs, and every CAPTURE_POLL_MS to close shots whose
+// channels did not all fire. Being above the loop task, it sees the edges
+// held up by a flash operation before the loop can start another one.
+void captureTask(void *) {
+  Edge edge;
+  ShotRecord record;
+  uint32_t slack = FLASH_SLACK_US * ticksPerUs;
+  bool stalled = false;
+  uint32_t stallFrom = 0, stallTo = 0; // late edges not yet in a shot
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAPTURE_POLL_MS));
+    while (edges.pop(edge)) {
+      if (flash.stalled(edge.ticks, slack)) {
+        if (!stalled)
+          stallFrom = edge.ticks;
+        stallTo = edge.ticks;
+        stalled = true;
+      }
+      correlator.feed(edge);
+#if TELEMETRY_EDGES
+      rawEdges.push(edge);
+#endif
+    }
+    correlator.poll(ESP.getCycleCount());
+    while (correlator.pop(record)) {
+      uint32_t end;
+
+      if (stalled && touches(record, stallFrom, stallTo, end)) {
+        stalledShots.store(stalledShots.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+      } else {
+        shots.push(record);
+      }
+      if (stalled && ((int32_t)(end - stallTo) >= 0))
+        stalled = false;
+    }
+  }
+}
+
+// Sleeps until loop() switches profiling on, then streams the ADC through
+// the light profile until it is switched off again.
+void profileTask(void *) {
+  static uint16_t samples[AdcStream::FRAME];
+#if FLICKER_HZ
+  static FlickerFilter flicker((float)profileRate / FLICKER_HZ,
+                               PROFILE_TRIGGER);
+#endif
+  LightProfile profile(PROFILE_TRIGGER,
+                       (uint64_t)PROFILE_HOLDOFF_US * profileRate / 1000000);
+  ProfileResult result;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    profile.reset();
+#if FLICKER_HZ
+    flicker.reset();
+#endif
+    adc.start();
+    while (profiling.load()) {
+      uint32_t count = adc.read(samples, AdcStream::FRAME, 20);
+
+#if FLICKER_HZ
+      flicker.process(samples, count);
+      if (!profile.active())
+        profile.trigger(flicker.threshold());
+#endif
+
+      for (uint32_t used = 0; used < count;) {
+        used += profile.feed(samples + used, count - used);
+        if (profile.pop(result))
+          profiles.push(result);
+      }
+    }
+    adc.stop();
+  }
+}
+
+void profileMode(bool on) {
+  if ((on == profiling.load()) || !profileTaskHandle)
+    return;
+  if (on) {
+    lastProfile = {};
+    detachInterrupt(digitalPinToInterrupt(PROFILE_PIN));
+    // The pull-down would load the amplifier output the ADC samples.
+    pinMode(PROFILE_PIN, INPUT);
+    profiling.store(true);
+    xTaskNotifyGive(profileTaskHandle);
+  } else {
+    profiling.store(false);
+    for (uint8_t i = 0; i < SENSOR_CHANNELS; ++i) {
+      if (SENSOR_PINS[i] == PROFILE_PIN) {
+        pinMode(SENSOR_PINS[i], INPUT_PULLDOWN);
+        attachInterrupt(digitalPinToInterrupt(SENSOR_PINS[i]), SENSOR_ISRS[i],
+                        CHANGE);
+      }
+    }
+  }
+  dirty = true;
+}
+
+// At most six big cells, "1/9999", so the readout stays clear of the chart:
+// anything faster is shown in microseconds and anything slower than 10s in
+// whole seconds.
+static_assert(6 * decltype(readout)::advance('0') <= CHART_X,
+              "the readout runs into the chart");
+
+void formatSpeed(char *text, size_t size, float us) {
+  if (us < 1000000.0f / 9999.5f) {
+    snprintf(text, size, "%.1fus", us);
+  } else if (us < 1000000.0f / 2) {
+    snprintf(text, size, "1/%.0f", 1000000.0f / us);
+  } else if (us < 10000000.0f) {
+    snprintf(text, size, "%.2fs", us / 1000000.0f);
+  } else {
+    snprintf(text, size, "%.0fs", us / 1000000.0f);
+  }
+}
+
+void restart(float nominal) {
+  stats.reset(nominal);
+  if (!splash)
+    chart.begin();
+  dirty = true;
+}
+
+void onShot(const ShotRecord &record) {
+  float us = (float)record.exposure() / ticksPerUs;
+  char text[16];
+
+  formatSpeed(text, sizeof(text), us);
+  stats.add(us);
+  if (!splash)
+    chart.add(stats.stops(us));
+  if (logging)
+    shotLog.append(record);
+#if TELEMETRY
+  telemetry.shot(record);
+#else
+  Serial.printf("exposure %.1fus %s n=%u mean=%.1fus sd=%.1fus %+.2fEV\n", us,
+                text, (unsigned)stats.count(), stats.mean(), stats.stddev(),
+                stats.stops());
+  if (record.first() != record.last()) {
+    Serial.printf("travel %.1fus/%.1fus spread %.1fus\n",
+                  (float)record.openTravel() / ticksPerUs,
+                  (float)record.closeTravel() / ticksPerUs,
+                  (float)record.spread() / ticksPerUs);
+  }
+#endif
+  lastShot = record;
+  dirty = true;
+}
+
+void onProfile(const ProfileResult &result) {
+#if TELEMETRY
+  telemetry.profile(result);
+#else
+  float us = 1000000.0f / profileRate;
+
+  Serial.printf("profile base=%u peak=%u width=%.1fus half=%.1fus "
+                "effective=%.1fus\n",
+                result.baseline, result.peak, result.samples * us,
+                result.half * us, result.effective * us);
+#endif
+  lastProfile = result;
+  dirty = true;
+}
+
+#if TELEMETRY
+// Hands the port as many queued bytes as it will take without blocking.
+void flushTelemetry() {
+  size_t count = Serial.availableForWrite();
+
+  if (count > telemetry.pending())
+    count = telemetry.pending();
+  if (count) {
+    Serial.write(telemetry.data(), count);
+    telemetry.consume(count);
+  }
+}
+#endif
+
+// Reads the stored latency table; one taken at another clock speed is no use.
+void loadLatency() {
+  Preferences prefs;
+
+  prefs.begin("shutter", true);
+  if ((prefs.getBytes("latency", &latency, sizeof(latency)) !=
+       sizeof(latency)) ||
+      !latency.valid() || (latency.ticksPerUs != ticksPerUs))
+    latency = LatencyTable();
+  prefs.end();
+}
+
+// NVS is flash too, so the write is tracked like the shot log's.
+void saveLatency() {
+  flash.guard([] {
+    Preferences prefs;
+
+    prefs.begin("shutter", false);
+    prefs.putBytes("latency", &latency, sizeof(latency));
+    prefs.end();
+    return true;
+  });
+}
+
+// One LED pulse of `ticks`, with the cycle counts just after each pin write.
+bool drivePulse(uint32_t ticks, uint32_t &on, uint32_t &off) {
+  uint32_t slack = CALIBRATION_SLACK_US * ticksPerUs;
+  uint32_t before = ESP.getCycleCount();
+
+  digitalWrite(CALIBRATION_PIN, HIGH);
+  on = ESP.getCycleCount();
+
+  bool clean = on - before < slack;
+
+  while (ESP.getCycleCount() - on < ticks)
+    ;
+  before = ESP.getCycleCount();
+  digitalWrite(CALIBRATION_PIN, LOW);
+  off = ESP.getCycleCount();
+  return clean && (off - before < slack);
+}
+
+// Blocks the loop for a few seconds; shots arriving meanwhile are the
+// calibration pulses and are not shown or logged.
+void calibrate() {
+  static LatencyCalibrator calibrator(SENSOR_CHANNELS);
+  ShotRecord record;
+  LatencyTable table;
+
+  readout.print("cal");
+  calibrator.reset();
+  for (uint32_t us = 125; calibrator.begin(us * ticksPerUs); us *= 2) {
+    for (uint8_t tries = 0; (calibrator.count() < CALIBRATION_REPS) &&
+                            (tries < 2 * CALIBRATION_REPS);
+         ++tries) {
+      uint32_t on, off, start = millis();
+      bool seen = false;
+
+      while (shots.pop(record))
+        ;
+      if (!drivePulse(us * ticksPerUs, on, off))
+        continue;
+      while (!(seen = shots.pop(record)) &&
+             (millis() - start < CALIBRATION_TIMEOUT_MS))
+        delay(1);
+      if (seen)
+        calibrator.add(on, off, record);
+    }
+  }
+  bool fitted = calibrator.fit(table, ticksPerUs);
+
+  if (fitted) {
+    latency = table;
+    saveLatency();
+  }
+#if !TELEMETRY
+  if (fitted) {
+    for (uint8_t i = 0; i < SENSOR_CHANNELS; ++i) {
+      Serial.printf("latency %u: rise %.2fus fall %.2fus\n", i,
+                    (float)latency.rise[i] / ticksPerUs,
+                    (float)latency.fall[i] / ticksPerUs);
+    }
+  } else {
+    Serial.println("calibration failed: the LED did not reach every sensor");
+  }
+#endif
+  restart(stats.nominal());
+}
+
+void handleKey(const Keys::Event &event) {
+  if (!event.pressed)
+    return;
+  switch (event.key) {
+  case Keys::CENTRE:
+    // Start a fresh series at the same speed, and a new session in the log:
+    // one per camera body.
+    restart(stats.nominal());
+    if (logging)
+      shotLog.session(ticksPerUs);
+    break;
+  case Keys::RIGHT:
+    profileMode(!profiling.load());
+    break;
+  case Keys::LEFT:
+    if (!profiling.load())
+      calibrate();
+    break;
+  case Keys::UP:
+  case Keys::DOWN:
+    // The dial was turned: a new series against the next marked speed.
+    if (!profiling.load()) {
+      restart(
+          ShotStats::step(stats.nominal(), event.key == Keys::UP ? -1 : 1));
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void printHistory() {
+  LogSession sessions[HISTORY_SESSIONS];
+  uint32_t count = shotLog.sessions(sessions, HISTORY_SESSIONS);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    float sum = 0;
+    uint32_t shots = shotLog.shots(sessions[i], [&](const ShotRecord &record) {
+      sum += (float)record.exposure() / sessions[i].ticksPerUs;
+    });
+
+    Serial.printf("session %u: %u shots, mean %.1fus\n",
+                  (unsigned)sessions[i].number, (unsigned)shots,
+                  shots ? sum / shots : 0);
+  }
+}
+
+// Runs from the first loop() pass, with the sensors already live: the first
+// mount formats the partition, which takes a few seconds.
+void openLog() {
+  if (flash.begin() && shotLog.mount()) {
+#if !TELEMETRY
+    printHistory();
+#endif
+    logging = shotLog.session(ticksPerUs);
+  } else {
+#if !TELEMETRY
+    Serial.println("Shot log unavailable");
+#endif
+  }
+}
+
+// The big readout and the frame buffer both keep track of what is on the
+// panel, so a refresh only sends the segments and text pixels that changed.
+void render() {
+  char text[16];
+  char line[2][24];
+
+  if (profiling.load()) {
+    float us = 1000000.0f / profileRate;
+
+    if (lastProfile.peak)
+      formatSpeed(text, sizeof(text), lastProfile.half * us);
+    else
+      snprintf(text, sizeof(text), "----");
+    readout.print(text);
+    formatSpeed(text, sizeof(text), lastProfile.effective * us);
+    snprintf(line[0], sizeof(line[0]), "%-11s", "profile");
+    snprintf(line[1], sizeof(line[1]), "eff %-7s",
+             lastProfile.peak ? text : "");
+  } else {
+    if (stats.count())
+      formatSpeed(text, sizeof(text), (float)lastShot.exposure() / ticksPerUs);
+    else
+      snprintf(text, sizeof(text), "----");
+    readout.print(text);
+    formatSpeed(text, sizeof(text), stats.nominal());
+    snprintf(line[0], sizeof(line[0]), "%-6s%5u", text,
+             (unsigned)stats.count());
+    snprintf(line[1], sizeof(line[1]), "%+.2fEV    ", stats.stops());
+  }
+  fb.print(0, 44, line[0], Display::WHITE);
+  fb.print(0, 62, line[1], Display::WHITE);
+  fb.flush();
+}
+
+#if BENCH
+// Times the benchmark scenarios with the cycle counter.
+class CycleMeter {
+public:
+  template <class F> void measure(const char *name, uint32_t runs, F run) {
+    uint32_t start = ESP.getCycleCount();
+
+    for (uint32_t i = 0; i < runs; ++i)
+      run(i);
+
+    uint64_t ns = (uint64_t)(ESP.getCycleCount() - start) * 1000 / ticksPerUs;
+
+    Serial.printf("bench,%s,%u,%u,-,-,-,-,-\n", name, (unsigned)runs,
+                  (unsigned)(ns / runs));
+  }
+};
+#endif
 
 void setup() {
   Serial.begin(115200);
+#if !TELEMETRY
   Serial.println("Hello! ST7735 TFT");
+#endif
 
-  tft.init();
-  tft.setRotation(1);
-  tft.fillScreen(TFT_BLACK);
+  ticksPerUs = getCpuFrequencyMhz();
+  loadLatency();
+  pinMode(CALIBRATION_PIN, OUTPUT);
+  digitalWrite(CALIBRATION_PIN, LOW);
+  correlator = CurtainCorrelator(SENSOR_CHANNELS, SENSOR_GLITCH_US * ticksPerUs,
+                                 SENSOR_WINDOW_US * ticksPerUs);
+  xTaskCreate(captureTask, "capture", 4096, nullptr, CAPTURE_PRIORITY,
+              &captureTaskHandle);
+  profileRate = AdcStream::MAX_RATE;
+  if (adc.begin(PROFILE_PIN, profileRate)) {
+    xTaskCreate(profileTask, "profile", 4096, nullptr, CAPTURE_PRIORITY,
+                &profileTaskHandle);
+  } else {
+#if !TELEMETRY
+    Serial.println("ADC continuous mode unavailable");
+#endif
+  }
+#if TELEMETRY
+  telemetry.info({ticksPerUs, profileRate});
+#endif
+  for (uint8_t i = 0; i < SENSOR_CHANNELS; ++i) {
+    pinMode(SENSOR_PINS[i], INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(SENSOR_PINS[i]), SENSOR_ISRS[i],
+                    CHANGE);
+  }
+  for (uint8_t i = 0; i < Keys::COUNT; ++i) {
+    pinMode(KEY_PINS[i], INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(KEY_PINS[i]), KEY_ISRS[i], CHANGE);
+  }
+
+  SPI.begin(TFT_SCLK, TFT_MISO, TFT_MOSI, TFT_SS);
+  lcd.begin();
+  lcd.flip(TFT_FLIP);
+#if !TELEMETRY
   Serial.println("Initialised");
+#endif
+#if BENCH
+  CycleMeter meter;
+  Bench<Display> bench(lcd, fb, ticksPerUs);
+
+  Serial.print(bench.header());
+  bench.run(meter);
+#endif
+
+  const char *title[] = {"SHUTTER", "SPEED", "TESTER"};
 
-  int16_t gutterSize = tft.fontHeight() / 2;
-  tft.fillScreen(TFT_BLACK);
-  tft.setTextSize(3);
-  tft.setTextColor(TFT_RED);
-  tft.setTextDatum(TC_DATUM);
-  tft.drawString("SHUTTER", tft.width() / 2, 0 + gutterSize);
-  tft.drawString("SPEED", tft.width() / 2, tft.fontHeight() + gutterSize);
-  tft.drawString("TESTER", tft.width() / 2, (tft.fontHeight() * 2) + gutterSize);
+  for (uint8_t i = 0; i < 3; ++i) {
+    lcd.print((lcd.width() - strlen(title[i]) * lcd.charWidth()) / 2,
+              4 + i * 28, title[i], Display::RED);
+  }
+  chart.range(-CHART_EV, CHART_EV, 0);
 
-  delay(1000);
-  tft.fillScreen(TFT_BLACK);
+  // The splash stays up while the loop runs; shots fired meanwhile are
+  // measured and shown once it goes.
+  splashUntil = millis() + SPLASH_MS;
 }
 
 void loop() {
-  delay(500);
+  static bool opened = false;
+  ShotRecord record;
+
+  ProfileResult profile;
+
+  if (!opened) {
+    opened = true;
+    openLog();
+  }
+
+  while (shots.pop(record)) {
+    latency.apply(record);
+    onShot(record);
+  }
+  while (profiles.pop(profile)) {
+    onProfile(profile);
+  }
+#if TELEMETRY_EDGES
+  Edge edge;
+
+  while (rawEdges.pop(edge)) {
+    telemetry.edge(edge);
+  }
+#endif
+
+  uint32_t now = millis();
+  Keys::Event event;
+
+  keys.poll(now, readKeys());
+  while (keys.pop(event)) {
+    handleKey(event);
+  }
+
+  if (splash && ((int32_t)(now - splashUntil) >= 0)) {
+    splash = false;
+    lcd.clear();
+    readout.invalidate();
+    chart.begin();
+    dirty = true;
+  }
+  if (!splash && dirty && refresh.due(now)) {
+    dirty = false;
+    render();
+  }
+
+#if TELEMETRY
+  flushTelemetry();
+#else
+  static uint32_t overruns = 0;
+  if (edges.overruns() + shots.overruns() != overruns) {
+    overruns = edges.overruns() + shots.overruns();
+    Serial.printf("overruns: %u edges, %u shots\n",
+                  (unsigned)edges.overruns(), (unsigned)shots.overruns());
+  }
+  static uint32_t stalled = 0;
+  if (stalledShots.load(std::memory_order_relaxed) != stalled) {
+    stalled = stalledShots.load(std::memory_order_relaxed);
+    Serial.printf("dropped: %u shots timed during flash access\n",
+                  (unsigned)stalled);
+  }
+#endif
+
+  // One scheduler tick: lets the idle task run and bounds key latency.
+  delay(1);
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for the slice of the Arduino core used by the sketch modules.
+// Pin writes are recorded on host::bus and time only moves when something
+// waits, so runs are deterministic.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Bus.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+#define IRAM_ATTR
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t val) { host::bus.pin(pin, val); }
+inline int digitalRead(uint8_t pin) { return host::bus.level(pin); }
+
+inline uint32_t micros() { return host::bus.micros(); }
+inline uint32_t millis() { return host::bus.micros() / 1000; }
+inline void delayMicroseconds(uint32_t us) { host::bus.advance(us); }
+inline void delay(uint32_t ms) { host::bus.advance(ms * 1000); }
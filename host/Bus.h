@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Everything the host shims see on the pins and the SPI bus, in order. The
+// driver under test can be replayed from this, and two builds can be compared
+// byte for byte through digest().
+namespace host {
+
+struct Event {
+  enum Kind : uint8_t { PIN, BEGIN, END, BYTE };
+
+  Kind kind;
+  uint8_t pin;
+  uint8_t value;
+};
+
+struct Stats {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t commands;
+  uint32_t dcToggles;
+  uint32_t csAsserts;
+  uint32_t digest;
+};
+
+class Bus {
+public:
+  static const uint8_t PINS = 64;
+
+  void pin(uint8_t pin, uint8_t level);
+  void begin() { _events.push_back({Event::BEGIN, 0, 0}); }
+  void end() { _events.push_back({Event::END, 0, 0}); }
+  void byte(uint8_t data) { _events.push_back({Event::BYTE, 0, data}); }
+
+  uint8_t level(uint8_t pin) const { return _levels[pin % PINS]; }
+  void level(uint8_t pin, uint8_t level) { _levels[pin % PINS] = level; }
+
+  size_t mark() const { return _events.size(); }
+  void clear() { _events.clear(); }
+  const std::vector<Event> &events() const { return _events; }
+
+  Stats stats(uint8_t dc, uint8_t cs, size_t from = 0) const;
+
+  uint32_t micros() const { return _micros; }
+  void advance(uint32_t us) { _micros += us; }
+
+protected:
+  std::vector<Event> _events;
+  uint8_t _levels[PINS] = {};
+  uint32_t _micros = 0;
+};
+
+inline void Bus::pin(uint8_t pin, uint8_t level) {
+  _events.push_back({Event::PIN, pin, level});
+  _levels[pin % PINS] = level;
+}
+
+// Summarises the events since `from`. A byte counts as a command when DC is
+// low; the digest is FNV-1a over every byte tagged with its DC level.
+inline Stats Bus::stats(uint8_t dc, uint8_t cs, size_t from) const {
+  Stats stats = {0, 0, 0, 0, 0, 2166136261u};
+  uint8_t dcLevel = 1;
+
+  for (size_t i = from; i < _events.size(); ++i) {
+    const Event &event = _events[i];
+
+    switch (event.kind) {
+    case Event::PIN:
+      if (event.pin == dc) {
+        if (event.value != dcLevel)
+          ++stats.dcToggles;
+        dcLevel = event.value;
+      } else if ((event.pin == cs) && !event.value) {
+        ++stats.csAsserts;
+      }
+      break;
+    case Event::BEGIN:
+      ++stats.transactions;
+      break;
+    case Event::END:
+      break;
+    case Event::BYTE:
+      ++stats.bytes;
+      if (!dcLevel)
+        ++stats.commands;
+      stats.digest ^= event.value | (dcLevel << 8);
+      stats.digest *= 16777619u;
+      break;
+    }
+  }
+  return stats;
+}
+
+inline Bus bus;
+
+} // namespace host
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+// NOR flash kept in a file, for running ShotLog on the host. As on the real
+// part, erase sets a whole sector to 0xFF and programming can only clear
+// bits. cut() simulates power loss: once the given number of further bytes
+// have been programmed or erased, everything after is dropped and the call
+// in progress fails, leaving a torn write or a half erased sector behind.
+namespace host {
+
+class FileFlash {
+public:
+  static const uint32_t SECTOR = 4096;
+
+  FileFlash(FILE *file, uint32_t size);
+
+  uint32_t size() const { return _size; }
+  bool read(uint32_t address, void *data, uint32_t count);
+  bool write(uint32_t address, const void *data, uint32_t count);
+  bool erase(uint32_t address);
+
+  void cut(uint32_t budget) { _budget = budget; }
+  void restore() { _budget = UINT32_MAX; }
+  bool lost() const { return !_budget; }
+
+  uint32_t erases(uint32_t sector) const { return _erases[sector]; }
+
+protected:
+  uint32_t allow(uint32_t count);
+
+  FILE *_file;
+  uint32_t _size;
+  uint32_t _budget = UINT32_MAX;
+  std::vector<uint32_t> _erases;
+};
+
+// A file shorter than `size` is padded out as erased flash, first to the end
+// of its last sector and then a sector at a time.
+inline FileFlash::FileFlash(FILE *file, uint32_t size)
+    : _file(file), _size(size), _erases(size / SECTOR) {
+  uint8_t blank[SECTOR];
+  long length;
+
+  memset(blank, 0xFF, sizeof(blank));
+  fseek(_file, 0, SEEK_END);
+  length = ftell(_file);
+  for (uint32_t address = length; address < size;) {
+    uint32_t count = SECTOR - address % SECTOR;
+
+    fwrite(blank, 1, count, _file);
+    address += count;
+  }
+  fflush(_file);
+}
+
+inline uint32_t FileFlash::allow(uint32_t count) {
+  if (count > _budget)
+    count = _budget;
+  if (_budget != UINT32_MAX)
+    _budget -= count;
+  return count;
+}
+
+inline bool FileFlash::read(uint32_t address, void *data, uint32_t count) {
+  if (address + count > _size)
+    return false;
+  fseek(_file, address, SEEK_SET);
+  return fread(data, 1, count, _file) == count;
+}
+
+inline bool FileFlash::write(uint32_t address, const void *data,
+                             uint32_t count) {
+  uint8_t cells[SECTOR];
+  uint32_t allowed;
+
+  if ((address + count > _size) || (count > SECTOR) ||
+      !read(address, cells, count))
+    return false;
+  allowed = allow(count);
+  for (uint32_t i = 0; i < allowed; ++i)
+    cells[i] &= ((const uint8_t *)data)[i];
+  fseek(_file, address, SEEK_SET);
+  fwrite(cells, 1, allowed, _file);
+  return allowed == count;
+}
+
+inline bool FileFlash::erase(uint32_t address) {
+  uint8_t blank[SECTOR];
+  uint32_t allowed;
+
+  if ((address % SECTOR) || (address >= _size))
+    return false;
+  memset(blank, 0xFF, sizeof(blank));
+  allowed = allow(SECTOR);
+  fseek(_file, address, SEEK_SET);
+  fwrite(blank, 1, allowed, _file);
+  ++_erases[address / SECTOR];
+  return allowed == SECTOR;
+}
+
+} // namespace host
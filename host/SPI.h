@@ -0,0 +1,57 @@
+#pragma once
+
+// Host stand-in for the ESP32 SPIClass. Nothing is clocked out; every byte and
+// transaction boundary is recorded on host::bus instead.
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST,
+              uint8_t dataMode = SPI_MODE0)
+      : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+
+  uint32_t _clock;
+  uint8_t _bitOrder;
+  uint8_t _dataMode;
+};
+
+class SPIClass {
+public:
+  void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+  void end() {}
+
+  void beginTransaction(SPISettings) { host::bus.begin(); }
+  void endTransaction() { host::bus.end(); }
+
+  uint8_t transfer(uint8_t data) {
+    host::bus.byte(data);
+    return 0;
+  }
+  uint16_t transfer16(uint16_t data) {
+    host::bus.byte(data >> 8);
+    host::bus.byte(data);
+    return 0;
+  }
+
+  void writeBytes(const uint8_t *data, uint32_t size) {
+    while (size--)
+      host::bus.byte(*data++);
+  }
+  // Like the ESP32 core: native 16-bit pixels go out most significant first.
+  void writePixels(const void *data, uint32_t size) {
+    const uint16_t *pixels = (const uint16_t *)data;
+
+    for (; size > 1; size -= 2)
+      transfer16(*pixels++);
+  }
+  void writePattern(const uint8_t *data, uint8_t size, uint32_t repeat) {
+    while (repeat--)
+      writeBytes(data, size);
+  }
+};
+
+inline SPIClass SPI;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+// The host reports, one per module in test_<module>.cpp. Each prints its part
+// of the report and returns how many of its checks failed.
+
+static const uint32_t TICKS_PER_US = 160;
+
+// Deterministic jitter for the synthetic inputs: uniform in [-1, 1). One
+// sequence is shared by every report.
+inline float noise() {
+  static uint32_t state = 1;
+
+  state = state * 1664525u + 1013904223u;
+  return (int32_t)state / 2147483648.0f;
+}
+
+uint32_t reportDisplay();
+uint32_t reportPacking();
+uint32_t reportCapture();
+uint32_t reportStats();
+uint32_t reportCurtain();
+uint32_t reportCalibration();
+uint32_t reportQueue();
+uint32_t reportProfile();
+uint32_t reportFlicker();
+uint32_t reportTelemetry();
+uint32_t reportShotLog();
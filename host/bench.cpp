@@ -0,0 +1,273 @@
+// Runs the Bench.h scenarios against the host shims and checks them against
+// a baseline. Bus counts are deterministic and may not grow at all. Wall time
+// moves with the machine and its load, so each scenario's time ratio is taken
+// relative to the median ratio of the run, and a scenario that slowed by more
+// than the tolerance factor against the others counts. That alone would let
+// a slowdown common to every scenario through, so the median ratio itself
+// may not exceed the tolerance squared.
+//
+//   bench [-o results] [-b baseline] [-t tolerance] [--wire]
+//   bench --compare baseline results [-t tolerance]
+//
+// Files hold "bench," lines as printed by either backend, anything else is
+// ignored, so a saved Serial log of the device run compares as well. --wire
+// reports instead the time each scenario's bytes take on the bus at
+// SPI_FREQUENCY, with the counts left out as the device leaves them: the
+// floor under any device run.
+
+#include <stdlib.h>
+
+#include <chrono>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "ST7735S.h"
+#include "tft-setup.h"
+
+static const uint32_t TICKS_PER_US = 160;
+
+static ST7735S<TFT_DC, TFT_CS, TFT_RST, SPI, SPI_FREQUENCY, LCD_BL> lcd;
+static FrameBuffer<decltype(lcd)> fb(lcd);
+
+// One line of results; counts are per run and negative where unknown.
+struct Result {
+  static const uint8_t COUNTS = 5;
+
+  std::string name;
+  uint32_t runs;
+  double ns;
+  double counts[COUNTS];
+};
+
+static const char *const COUNT_NAMES[Result::COUNTS] = {"trans", "bytes",
+                                                        "cmds", "dc", "cs"};
+
+// The last run goes once untimed first, so cached windows are settled and
+// alternating scenarios start on a change. Wall time is the fastest of a few
+// batches; the bus is counted on the first.
+class HostMeter {
+public:
+  static const uint8_t BATCHES = 5;
+
+  template <class F> void measure(const char *name, uint32_t runs, F run) {
+    Result result = {name, runs, 0, {}};
+
+    run(runs - 1);
+    for (uint8_t batch = 0; batch < BATCHES; ++batch) {
+      host::bus.clear();
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < runs; ++i)
+        run(i);
+      std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+
+      if (!batch || (elapsed.count() / runs < result.ns))
+        result.ns = elapsed.count() / runs;
+      if (!batch) {
+        host::Stats stats = host::bus.stats(TFT_DC, TFT_CS);
+
+        result.counts[0] = (double)stats.transactions / runs;
+        result.counts[1] = (double)stats.bytes / runs;
+        result.counts[2] = (double)stats.commands / runs;
+        result.counts[3] = (double)stats.dcToggles / runs;
+        result.counts[4] = (double)stats.csAsserts / runs;
+      }
+    }
+    host::bus.clear();
+    results.push_back(result);
+  }
+
+  std::vector<Result> results;
+};
+
+static void write(FILE *out, const std::vector<Result> &results) {
+  fputs(Bench<decltype(lcd)>::header(), out);
+  for (const Result &r : results) {
+    fprintf(out, "bench,%s,%u,%.0f", r.name.c_str(), r.runs, r.ns);
+    for (double count : r.counts) {
+      if (count < 0)
+        fprintf(out, ",-");
+      else
+        fprintf(out, ",%g", count);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+static bool read(const char *path, std::vector<Result> &results) {
+  FILE *in = fopen(path, "r");
+  char line[256];
+
+  if (!in) {
+    fprintf(stderr, "bench: cannot open %s\n", path);
+    return false;
+  }
+  while (fgets(line, sizeof(line), in)) {
+    std::vector<std::string> fields;
+    std::string field;
+
+    if (strncmp(line, "bench,", 6))
+      continue;
+    for (char *p = line + 6; *p && (*p != '\n') && (*p != '\r'); ++p) {
+      if (*p == ',') {
+        fields.push_back(field);
+        field.clear();
+      } else {
+        field += *p;
+      }
+    }
+    fields.push_back(field);
+    if (fields.size() != 3 + Result::COUNTS)
+      continue;
+
+    Result r = {fields[0], (uint32_t)atol(fields[1].c_str()),
+                atof(fields[2].c_str()), {}};
+
+    for (uint8_t i = 0; i < Result::COUNTS; ++i)
+      r.counts[i] = fields[3 + i] == "-" ? -1 : atof(fields[3 + i].c_str());
+    results.push_back(r);
+  }
+  fclose(in);
+  return true;
+}
+
+// Time ratio of the middle scenario that is in both sets: how much faster or
+// slower this machine is running than the one the baseline came from.
+static double speed(const std::vector<Result> &baseline,
+                    const std::vector<Result> &results) {
+  std::vector<double> ratios;
+
+  for (const Result &base : baseline) {
+    for (const Result &r : results) {
+      if ((r.name == base.name) && (base.ns > 0) && (r.ns > 0))
+        ratios.push_back(r.ns / base.ns);
+    }
+  }
+  if (ratios.empty())
+    return 1;
+  std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2,
+                   ratios.end());
+  return ratios[ratios.size() / 2];
+}
+
+// Prints one row per baseline scenario and returns the number that regressed,
+// plus one if the run as a whole is too slow.
+static uint32_t compare(const std::vector<Result> &baseline,
+                        const std::vector<Result> &results, double tolerance) {
+  double machine = speed(baseline, results);
+  uint32_t regressions = machine > tolerance * tolerance;
+
+  printf("%-18s %10s %10s %6s  %s\n", "scenario", "base ns", "ns", "ratio",
+         "verdict");
+  for (const Result &base : baseline) {
+    auto found =
+        std::find_if(results.begin(), results.end(),
+                     [&](const Result &r) { return r.name == base.name; });
+    std::string verdict;
+
+    if (found == results.end()) {
+      printf("%-18s %10.0f %10s %6s  missing\n", base.name.c_str(), base.ns,
+             "-", "-");
+      ++regressions;
+      continue;
+    }
+
+    double ratio = base.ns > 0 ? found->ns / base.ns / machine : 1;
+    bool regressed = ratio > tolerance;
+
+    if (regressed)
+      verdict += " slower";
+    for (uint8_t i = 0; i < Result::COUNTS; ++i) {
+      if ((base.counts[i] < 0) || (found->counts[i] < 0))
+        continue;
+      if (found->counts[i] > base.counts[i] + 1e-6) {
+        verdict += std::string(" more ") + COUNT_NAMES[i];
+        regressed = true;
+      } else if (found->counts[i] < base.counts[i] - 1e-6) {
+        verdict += std::string(" fewer ") + COUNT_NAMES[i];
+      }
+    }
+    regressions += regressed;
+    printf("%-18s %10.0f %10.0f %6.2f %s\n", base.name.c_str(), base.ns,
+           found->ns, ratio, verdict.empty() ? " ok" : verdict.c_str());
+  }
+  printf("machine speed x%.2f of the baseline's, ratios are relative to it\n",
+         1 / machine);
+  if (machine > tolerance * tolerance)
+    printf("every scenario slowed: median ratio %.2f over x%.2f\n", machine,
+           tolerance * tolerance);
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  const char *output = nullptr, *baseline = nullptr, *results = nullptr;
+  double tolerance = 1.5;
+  bool wire = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-o") && (i + 1 < argc)) {
+      output = argv[++i];
+    } else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) {
+      baseline = argv[++i];
+    } else if (!strcmp(argv[i], "-t") && (i + 1 < argc)) {
+      tolerance = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--wire")) {
+      wire = true;
+    } else if (!strcmp(argv[i], "--compare") && (i + 2 < argc)) {
+      baseline = argv[++i];
+      results = argv[++i];
+    } else {
+      fprintf(stderr,
+              "usage: bench [-o results] [-b baseline] [-t tolerance] "
+              "[--wire]\n"
+              "       bench --compare baseline results [-t tolerance]\n");
+      return 2;
+    }
+  }
+
+  std::vector<Result> current, base;
+
+  if (results) {
+    if (!read(results, current))
+      return 2;
+  } else {
+    HostMeter meter;
+    Bench<decltype(lcd)> bench(lcd, fb, TICKS_PER_US);
+
+    lcd.begin();
+    bench.run(meter);
+    current = meter.results;
+    if (wire) {
+      for (Result &r : current) {
+        r.ns = r.counts[1] * 8 * 1e9 / SPI_FREQUENCY;
+        for (double &count : r.counts)
+          count = -1;
+      }
+    }
+    write(stdout, current);
+    if (output) {
+      FILE *out = fopen(output, "w");
+
+      if (!out) {
+        fprintf(stderr, "bench: cannot write %s\n", output);
+        return 2;
+      }
+      write(out, current);
+      fclose(out);
+    }
+  }
+  if (!baseline)
+    return 0;
+  if (!read(baseline, base))
+    return 2;
+  printf("\n");
+
+  uint32_t regressions = compare(base, current, tolerance);
+
+  printf("%u regressed against %s (time tolerance x%.2f)\n", regressions,
+         baseline, tolerance);
+  return regressions ? 1 : 0;
+}
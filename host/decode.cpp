@@ -0,0 +1,87 @@
+// Turns the binary telemetry stream into CSV, one row per record, with the
+// record type in the first column. Reads the file or serial device given on
+// the command line, or stdin. Times are converted to microseconds with the
+// tick rate from the last INFO record.
+//
+//   stty -F /dev/ttyACM0 raw && build/host/decode /dev/ttyACM0 > shots.csv
+
+#include <stdio.h>
+
+#include "Telemetry.h"
+
+static TelemetryInfo info = {160, 83333};
+
+static void header() {
+  printf("# info,seq,ticks_per_us,profile_rate\n");
+  printf("# shot,seq,mask,exposure_us,open_travel_us,close_travel_us,"
+         "spread_us");
+  for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i)
+    printf(",offset%u_us,width%u_us", i, i);
+  printf("\n# profile,seq,baseline,peak,samples,half_us,effective_us,"
+         "integral\n");
+  printf("# edge,seq,ticks,channel,level\n");
+}
+
+static void row(const TelemetryRecord &record) {
+  float tick = 1.0f / info.ticksPerUs;
+  float sample = 1000000.0f / info.profileRate;
+
+  switch (record.type) {
+  case Telemetry::INFO:
+    info = record.info;
+    printf("info,%u,%u,%u\n", record.seq, info.ticksPerUs, info.profileRate);
+    break;
+  case Telemetry::SHOT: {
+    const ShotRecord &shot = record.shot;
+    uint32_t first = shot.open[shot.first()];
+
+    printf("shot,%u,%u,%.2f,%.2f,%.2f,%.2f", record.seq, shot.mask,
+           shot.exposure() * tick, shot.openTravel() * tick,
+           shot.closeTravel() * tick, shot.spread() * tick);
+    for (uint8_t i = 0; i < ShotRecord::MAX_CHANNELS; ++i) {
+      if (shot.mask & (1 << i))
+        printf(",%.2f,%.2f", (int32_t)(shot.open[i] - first) * tick,
+               shot.width[i] * tick);
+      else
+        printf(",,");
+    }
+    printf("\n");
+    break;
+  }
+  case Telemetry::PROFILE:
+    printf("profile,%u,%u,%u,%u,%.2f,%.2f,%u\n", record.seq,
+           record.profile.baseline, record.profile.peak,
+           record.profile.samples, record.profile.half * sample,
+           record.profile.effective * sample, record.profile.integral);
+    break;
+  case Telemetry::EDGE:
+    printf("edge,%u,%u,%u,%u\n", record.seq, record.edge.ticks,
+           record.edge.channel, record.edge.level);
+    break;
+  }
+}
+
+int main(int argc, char **argv) {
+  FILE *in = argc > 1 ? fopen(argv[1], "rb") : stdin;
+  TelemetryReader reader;
+  TelemetryRecord record;
+  uint32_t records = 0;
+  int c;
+
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+  // Rows appear as shots are fired when following a live device.
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  header();
+  while ((c = getc(in)) != EOF) {
+    if (reader.feed(c, record)) {
+      row(record);
+      ++records;
+    }
+  }
+  fprintf(stderr, "%u records, %u bad frames, %u lost\n", records,
+          reader.errors(), reader.lost());
+  return 0;
+}
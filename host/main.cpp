@@ -0,0 +1,24 @@
+// Runs the display driver and the capture logic natively, one report per
+// module. The exit status is non-zero if any check failed.
+
+#include <stdio.h>
+
+#include "Test.h"
+
+int main() {
+  uint32_t failures = 0;
+
+  failures += reportDisplay();
+  failures += reportPacking();
+  failures += reportCapture();
+  failures += reportStats();
+  failures += reportCurtain();
+  failures += reportCalibration();
+  failures += reportQueue();
+  failures += reportProfile();
+  failures += reportFlicker();
+  failures += reportTelemetry();
+  failures += reportShotLog();
+  printf("\n%u checks failed\n", failures);
+  return failures ? 1 : 0;
+}
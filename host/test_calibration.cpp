@@ -0,0 +1,114 @@
+// Sensor latency calibration against a synthetic LED and sensor model.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Calibration.h"
+#include "Curtain.h"
+#include "Test.h"
+
+// Synthetic sensor latency: fixed rise and fall delays, a fall that comes
+// early on pulses too short to charge the photodiode (`droop` at zero width,
+// decaying over 300us), up to 0.3us of ISR jitter per edge and one edge in
+// twenty held up 10us behind another interrupt. All in microseconds.
+struct SensorModel {
+  float rise, fall, droop;
+};
+
+static const SensorModel SENSORS[3] = {
+    {1.2f, 3.0f, 1.5f}, {1.5f, 2.6f, 1.8f}, {0.9f, 3.4f, 1.2f}};
+
+static uint32_t random(uint32_t &state) {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+// An LED pulse of `ticks` starting at `on`, as the sensors report it.
+static bool pulse(CurtainCorrelator &correlator, uint32_t on, uint32_t ticks,
+                  uint32_t &seed, ShotRecord &record) {
+  Edge edges[6];
+
+  for (uint8_t i = 0; i < 3; ++i) {
+    const SensorModel &m = SENSORS[i];
+    float fall = m.fall - m.droop * expf(-(float)ticks / TICKS_PER_US / 300);
+    uint32_t jitter[2];
+
+    for (uint32_t &j : jitter) {
+      j = random(seed) % (3 * TICKS_PER_US / 10);
+      if (!(random(seed) % 20))
+        j += 10 * TICKS_PER_US;
+    }
+    edges[2 * i] = {on + (uint32_t)(m.rise * TICKS_PER_US) + jitter[0], i, 1};
+    edges[2 * i + 1] = {on + ticks + (uint32_t)(fall * TICKS_PER_US) +
+                            jitter[1],
+                        i, 0};
+  }
+  std::sort(edges, edges + 6, [](const Edge &a, const Edge &b) {
+    return (int32_t)(a.ticks - b.ticks) < 0;
+  });
+  for (const Edge &edge : edges)
+    correlator.feed(edge);
+  correlator.poll(on + ticks + 10000 * TICKS_PER_US);
+  return correlator.pop(record);
+}
+
+// Fits a table from 32 pulses at each of eight widths, 1/8000 to 1/60, then
+// gives the median exposure error at other speeds with and without it. The
+// corrected error must stay within 100ns.
+uint32_t reportCalibration() {
+  CurtainCorrelator correlator(3, 5 * TICKS_PER_US, 2000 * TICKS_PER_US);
+  LatencyCalibrator calibrator(3);
+  LatencyTable table;
+  ShotRecord record;
+  uint32_t seed = 1, now = 0, failures = 0;
+
+  for (uint32_t us = 125; calibrator.begin(us * TICKS_PER_US); us *= 2) {
+    while (calibrator.count() < LatencyCalibrator::REPS) {
+      now += 50000 * TICKS_PER_US;
+      if (pulse(correlator, now, us * TICKS_PER_US, seed, record))
+        calibrator.add(now, now + us * TICKS_PER_US, record);
+    }
+  }
+  if (!calibrator.fit(table, TICKS_PER_US)) {
+    printf("\ncalibration: fit failed\n");
+    return 1;
+  }
+  printf("\ncalibration: rise us %.2f %.2f %.2f, fall us %.2f %.2f %.2f\n",
+         table.rise[0] / (float)TICKS_PER_US,
+         table.rise[1] / (float)TICKS_PER_US,
+         table.rise[2] / (float)TICKS_PER_US,
+         table.fall[0] / (float)TICKS_PER_US,
+         table.fall[1] / (float)TICKS_PER_US,
+         table.fall[2] / (float)TICKS_PER_US);
+  printf("%-8s %12s %12s\n", "speed", "raw ns", "corrected ns");
+  for (float speed : {8000.0f, 6000.0f, 3000.0f, 1500.0f, 750.0f, 250.0f,
+                      30.0f}) {
+    uint32_t ticks = 1000000.0f / speed * TICKS_PER_US;
+    std::vector<int32_t> raw, corrected;
+    char name[12];
+
+    for (uint32_t i = 0; i < 201; ++i) {
+      now += 50000 * TICKS_PER_US;
+      if (!pulse(correlator, now, ticks, seed, record))
+        continue;
+      raw.push_back(record.exposure() - ticks);
+      table.apply(record);
+      corrected.push_back(record.exposure() - ticks);
+    }
+    std::nth_element(raw.begin(), raw.begin() + raw.size() / 2, raw.end());
+    std::nth_element(corrected.begin(),
+                     corrected.begin() + corrected.size() / 2,
+                     corrected.end());
+    snprintf(name, sizeof(name), "1/%.0f", speed);
+    printf("%-8s %12.0f %12.0f\n", name,
+           raw[raw.size() / 2] * 1000.0f / TICKS_PER_US,
+           corrected[corrected.size() / 2] * 1000.0f / TICKS_PER_US);
+    failures += abs(corrected[corrected.size() / 2]) * 1000 >
+                100 * (int32_t)TICKS_PER_US;
+  }
+  return failures;
+}
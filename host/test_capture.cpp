@@ -0,0 +1,81 @@
+// The capture path fed synthetic edge streams.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "Capture.h"
+#include "SpscQueue.h"
+#include "Test.h"
+
+// A synthetic shot: light on for `us`, with the sensor ringing across the
+// threshold for a couple of microseconds inside each transition.
+static uint16_t shot(Edge *edges, uint32_t start, float us,
+                     uint8_t channel = 0) {
+  uint32_t end = start + (uint32_t)(us * TICKS_PER_US);
+  uint16_t count = 0;
+
+  edges[count++] = {start, channel, 1};
+  edges[count++] = {start + 1 * TICKS_PER_US, channel, 0};
+  edges[count++] = {start + 2 * TICKS_PER_US, channel, 1};
+  edges[count++] = {end - 2 * TICKS_PER_US, channel, 0};
+  edges[count++] = {end - 1 * TICKS_PER_US, channel, 1};
+  edges[count++] = {end, channel, 0};
+  return count;
+}
+
+// Each exposure must come out within a tick of nominal, and the stream must
+// lose nothing.
+uint32_t reportCapture() {
+  static const float SPEEDS[] = {8000, 4000, 2000, 1000, 500, 250,
+                                 125,  60,   30,   15,   8,   4};
+  ExposureDetector detector(5 * TICKS_PER_US);
+  uint32_t now = 0, failures = 0;
+
+  printf("\n%-10s %12s %12s %8s\n", "speed", "nominal us", "measured us",
+         "error %");
+  for (float speed : SPEEDS) {
+    Edge edges[6];
+    Exposure exposure = {0, 0};
+    float us = 1000000.0f / speed;
+    uint16_t count = shot(edges, now, us);
+
+    for (uint16_t i = 0; i < count; ++i)
+      detector.feed(edges[i], exposure);
+    now = edges[count - 1].ticks + 1000 * TICKS_PER_US;
+    detector.poll(now, exposure);
+
+    float measured = (float)exposure.ticks / TICKS_PER_US;
+    char name[12];
+    snprintf(name, sizeof(name), "1/%.0f", speed);
+    printf("%-10s %12.3f %12.3f %8.3f\n", name, us, measured,
+           100.0f * (measured - us) / us);
+    failures += fabsf(measured - us) * TICKS_PER_US > 1;
+  }
+
+  static SpscQueue<Edge, 256> ring;
+  const uint32_t SHOTS = 1000000;
+  uint32_t exposures = 0;
+  Edge edges[6], edge;
+  Exposure exposure;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < SHOTS; ++i) {
+    uint16_t count = shot(edges, now, 125);
+
+    for (uint16_t j = 0; j < count; ++j)
+      ring.push(edges[j]);
+    while (ring.pop(edge))
+      exposures += detector.feed(edge, exposure);
+    now += 1000 * TICKS_PER_US;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("\n%u edges -> %u exposures in %.3fs, %.1fM edges/s, %u overruns\n",
+         SHOTS * 6, exposures, elapsed.count(),
+         SHOTS * 6 / elapsed.count() / 1e6, ring.overruns());
+  // The last exposure closes only when an edge or a poll comes after it.
+  return failures + (exposures != SHOTS - 1) + (ring.overruns() != 0);
+}
@@ -0,0 +1,113 @@
+// Shot records correlated from three sensors across a focal plane shutter.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <algorithm>
+
+#include "Curtain.h"
+#include "Test.h"
+
+// Fixed latency of each sensor channel, in ticks.
+static const int32_t LATENCY[] = {0, 3 * (int32_t)TICKS_PER_US,
+                                  -2 * (int32_t)TICKS_PER_US};
+
+// Three sensors across the gate of a focal plane shutter whose second curtain
+// runs slower than the first, so exposure grows across the frame.
+static uint16_t curtainShot(Edge *edges, uint32_t start, float us) {
+  static const float POSITION[] = {0, 0.5f, 1};
+  const float FIRST_US = 3600, SECOND_US = 3800;
+
+  for (uint8_t i = 0; i < 3; ++i) {
+    uint32_t open = start + LATENCY[i] + POSITION[i] * FIRST_US * TICKS_PER_US;
+    uint32_t close =
+        start + LATENCY[i] + (us + POSITION[i] * SECOND_US) * TICKS_PER_US;
+
+    edges[i * 2] = {open, i, 1};
+    edges[i * 2 + 1] = {close, i, 0};
+  }
+  std::sort(edges, edges + 6, [](const Edge &a, const Edge &b) {
+    return (int32_t)(a.ticks - b.ticks) < 0;
+  });
+  return 6;
+}
+
+// The skews must match LATENCY, and after them every sensor must see the
+// travel times and widths laid out in curtainShot().
+uint32_t reportCurtain() {
+  CurtainCorrelator correlator(3, 5 * TICKS_PER_US, 20000 * TICKS_PER_US);
+  ShotRecord record;
+  Edge edges[6];
+  uint32_t now = 0, failures = 0;
+
+  // All three sensors lit at once by a flash sets the skew.
+  for (uint8_t i = 0; i < 3; ++i) {
+    correlator.feed({now + LATENCY[i], i, 1});
+  }
+  for (uint8_t i = 0; i < 3; ++i) {
+    correlator.feed({now + LATENCY[i] + 1000 * TICKS_PER_US, i, 0});
+  }
+  now += 100000 * TICKS_PER_US;
+  correlator.poll(now);
+  if (correlator.pop(record))
+    correlator.calibrate(record);
+
+  printf("\nskew us: %.2f %.2f %.2f\n",
+         correlator.skew(0) / (float)TICKS_PER_US,
+         correlator.skew(1) / (float)TICKS_PER_US,
+         correlator.skew(2) / (float)TICKS_PER_US);
+  for (uint8_t i = 0; i < 3; ++i)
+    failures += correlator.skew(i) != LATENCY[i];
+  printf("%-8s %10s %10s %10s %10s %10s %10s\n", "speed", "travel 1",
+         "travel 2", "exp 0", "exp 1", "exp 2", "spread");
+  for (float speed : {1000.0f, 250.0f, 60.0f}) {
+    uint16_t count = curtainShot(edges, now, 1000000.0f / speed);
+
+    for (uint16_t i = 0; i < count; ++i)
+      correlator.feed(edges[i]);
+    now += 200000 * TICKS_PER_US;
+    correlator.poll(now);
+    while (correlator.pop(record)) {
+      char name[12];
+      snprintf(name, sizeof(name), "1/%.0f", speed);
+      printf("%-8s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", name,
+             record.openTravel() / (float)TICKS_PER_US,
+             record.closeTravel() / (float)TICKS_PER_US,
+             record.width[0] / (float)TICKS_PER_US,
+             record.width[1] / (float)TICKS_PER_US,
+             record.width[2] / (float)TICKS_PER_US,
+             record.spread() / (float)TICKS_PER_US);
+      failures += !record.complete() ||
+                  (record.openTravel() != 3600 * (int32_t)TICKS_PER_US) ||
+                  (record.closeTravel() != 3800 * (int32_t)TICKS_PER_US) ||
+                  (record.spread() != 200 * TICKS_PER_US);
+    }
+  }
+
+  const uint32_t SHOTS = 1000000;
+  uint32_t records = 0, complete = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < SHOTS; ++i) {
+    uint16_t count = curtainShot(edges, now, 1000);
+
+    for (uint16_t j = 0; j < count; ++j)
+      correlator.feed(edges[j]);
+    now += 50000 * TICKS_PER_US;
+    correlator.poll(now);
+    while (correlator.pop(record)) {
+      ++records;
+      complete += record.complete();
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("%u shots -> %u records (%u complete, %u dropped) in %.3fs, "
+         "%.1fns/shot\n",
+         SHOTS, records, complete, correlator.dropped(), elapsed.count(),
+         elapsed.count() * 1e9 / SHOTS);
+  return failures + (records != SHOTS) + (complete != SHOTS) +
+         (correlator.dropped() != 0);
+}
@@ -0,0 +1,227 @@
+// Display primitives, the frame buffer and the widgets drawn against the
+// recording SPI shim, with the bus cost of each, and the pixel stream decoded
+// back in either colour mode.
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "BigReadout.h"
+#include "FrameBuffer.h"
+#include "ST7735S.h"
+#include "StripChart.h"
+#include "Test.h"
+#include "tft-setup.h"
+
+static ST7735S<TFT_DC, TFT_CS, TFT_RST, SPI, SPI_FREQUENCY, LCD_BL> lcd;
+static FrameBuffer<decltype(lcd)> fb(lcd);
+static StripChart<decltype(lcd)> chart(lcd, 0, 16, 100, 64);
+static BigReadout<decltype(lcd)> big(lcd, 4, 22);
+
+// Digests of what each primitive below puts on the wire, in 16 and in 12 bit
+// colour. They do not depend on ST7735S_BULK. Update them only with a change
+// that is meant to alter what the panel receives.
+static const struct {
+  const char *name;
+  uint32_t rgb565, rgb444;
+} DIGESTS[] = {
+    {"begin", 0x697fea9f, 0xb029df09},
+    {"clear", 0xda5d45cb, 0xc70119cb},
+    {"fill 40x20", 0xd0e8cace, 0xf2051e3e},
+    {"pixel", 0x3ae1db08, 0x39e1d975},
+    {"draw image", 0x4c11af14, 0x3b4837d6},
+    {"draw bits", 0x042e5c62, 0x574a5e7a},
+    {"print char", 0x395f3ca0, 0x26008788},
+    {"print 1/250", 0xd6ce9034, 0xf5e1ae39},
+    {"readout direct", 0x3f4ead5a, 0x364890df},
+    {"readout fb", 0x37b2c4f9, 0xdf52ec54},
+    {"readout fb 1/500", 0xff013127, 0x0dc63008},
+    {"big 1/250", 0xdf52ddbd, 0x6b031459},
+    {"big 1/251", 0xd5e71481, 0x7efa4181},
+    {"big 1/251 full", 0x2a1a0029, 0x2be0cffd},
+    {"big 4.02ms", 0x9e462dde, 0x12c5759e},
+    {"big 4.03ms", 0x70569d39, 0x837e5791},
+    {"chart begin", 0x4118b03c, 0x4878a366},
+    {"chart add", 0x5a614eb9, 0xd61141a6},
+    {"chart add x100", 0x2e081fe7, 0x4fa3021c},
+    {"chart redraw", 0x5327d10e, 0x17aeb50e},
+    {"chart end", 0x160c77e2, 0x160c77e2},
+    {"flip", 0x7de65ff3, 0x7de65ff3},
+};
+
+// One row of the bus cost table; fails if the digest is not the pinned one.
+template <typename F> static uint32_t report(const char *name, F draw) {
+  size_t mark = host::bus.mark();
+  uint32_t expected = 0;
+
+  draw();
+
+  host::Stats stats = host::bus.stats(TFT_DC, TFT_CS, mark);
+  for (const auto &pinned : DIGESTS) {
+    if (!strcmp(pinned.name, name))
+      expected = ST7735S_RGB444 ? pinned.rgb444 : pinned.rgb565;
+  }
+  printf("%-16s %6u %7u %5u %5u %5u  %08x", name, stats.transactions,
+         stats.bytes, stats.commands, stats.dcToggles, stats.csAsserts,
+         stats.digest);
+  if (stats.digest != expected)
+    printf("  expected %08x", expected);
+  printf("\n");
+  return stats.digest != expected;
+}
+
+uint32_t reportDisplay() {
+  static const uint16_t image[16 * 16] = {lcd.RED, lcd.GREEN, lcd.BLUE};
+  static const uint8_t bits[8 * 2] = {0xFF, 0x81, 0x81, 0x81,
+                                      0x81, 0x81, 0x81, 0xFF};
+  uint32_t failures = 0;
+
+  printf("%-16s %6s %7s %5s %5s %5s  %s\n", "primitive", "trans", "bytes",
+         "cmds", "dc", "cs", "digest");
+  failures += report("begin", [] { lcd.begin(); });
+  failures += report("clear", [] { lcd.clear(); });
+  failures += report("fill 40x20", [] { lcd.fill(10, 10, 40, 20, lcd.RED); });
+  failures += report("pixel", [] { lcd.pixel(5, 5, lcd.WHITE); });
+  failures += report("draw image", [] { lcd.draw(20, 20, 16, 16, image); });
+  failures +=
+      report("draw bits", [] { lcd.draw(40, 20, 8, 16, bits, lcd.GREEN); });
+  failures += report("print char", [] { lcd.print(0, 0, '8', lcd.WHITE); });
+  failures +=
+      report("print 1/250", [] { lcd.print(0, 16, "1/250", lcd.WHITE); });
+  failures += report("readout direct", [] {
+    lcd.fill(0, 32, 160, 32, lcd.GRAY);
+    lcd.print(40, 40, "1/250", lcd.WHITE, lcd.GRAY);
+    lcd.fill(40, 56, 40, 2, lcd.RED);
+  });
+  failures += report("readout fb", [] {
+    fb.fill(0, 32, 160, 32, lcd.GRAY);
+    fb.print(40, 40, "1/250", lcd.WHITE, lcd.GRAY);
+    fb.fill(40, 56, 40, 2, lcd.RED);
+    fb.flush();
+  });
+  failures += report("readout fb 1/500", [] {
+    fb.fill(0, 32, 160, 32, lcd.GRAY);
+    fb.print(40, 40, "1/500", lcd.WHITE, lcd.GRAY);
+    fb.fill(40, 56, 40, 2, lcd.RED);
+    fb.flush();
+  });
+  // Segment diffs against a forced full redraw of the same text.
+  failures += report("big 1/250", [] {
+    lcd.clear();
+    big.print("1/250");
+  });
+  failures += report("big 1/251", [] { big.print("1/251"); });
+  failures += report("big 1/251 full", [] {
+    big.invalidate();
+    big.print("1/251");
+  });
+  failures += report("big 4.02ms", [] { big.print("4.02ms"); });
+  failures += report("big 4.03ms", [] { big.print("4.03ms"); });
+  // Redrawing the plot without hardware scroll means pushing every column.
+  failures += report("chart begin", [] {
+    chart.range(-1, 1, 0);
+    chart.begin();
+  });
+  failures += report("chart add", [] { chart.add(0.1f); });
+  failures += report("chart add x100", [] {
+    for (uint32_t i = 0; i < 100; ++i)
+      chart.add(0.8f * sinf(i * 0.2f));
+  });
+  failures += report("chart redraw", [] {
+    static uint16_t plot[100 * 64];
+
+    lcd.draw(0, 16, 100, 64, plot);
+  });
+  failures += report("chart end", [] { chart.end(); });
+  failures += report("flip", [] { lcd.flip(true); });
+  host::bus.clear();
+  return failures;
+}
+
+// Pixels from one RAMWR, brought to RGB444 whatever the colour mode so both
+// builds compare alike. In 12 bit mode an odd count ends in half a byte.
+static void unpack(const std::vector<uint8_t> &bytes,
+                   std::vector<uint16_t> &pixels) {
+#if ST7735S_RGB444
+  for (size_t i = 0; i + 1 < bytes.size(); i += 3) {
+    pixels.push_back((bytes[i] << 4) | (bytes[i + 1] >> 4));
+    if (i + 2 < bytes.size())
+      pixels.push_back(((bytes[i + 1] & 0x0F) << 8) | bytes[i + 2]);
+  }
+#else
+  for (size_t i = 0; i + 1 < bytes.size(); i += 2)
+    pixels.push_back(lcd.rgb444((bytes[i] << 8) | bytes[i + 1]));
+#endif
+}
+
+// Pixel data written since `mark`; `count` is what it took on the bus.
+static std::vector<uint16_t> written(size_t mark, size_t &count) {
+  const std::vector<host::Event> &events = host::bus.events();
+  std::vector<uint8_t> bytes;
+  std::vector<uint16_t> pixels;
+  bool dc = true, ramwr = false;
+
+  count = 0;
+  for (size_t i = mark; i < events.size(); ++i) {
+    const host::Event &event = events[i];
+
+    if ((event.kind == host::Event::PIN) && (event.pin == TFT_DC))
+      dc = event.value;
+    if (event.kind != host::Event::BYTE)
+      continue;
+    if (!dc) {
+      unpack(bytes, pixels);
+      count += bytes.size();
+      bytes.clear();
+      ramwr = event.value == 0x2C;
+    } else if (ramwr) {
+      bytes.push_back(event.value);
+    }
+  }
+  unpack(bytes, pixels);
+  count += bytes.size();
+  return pixels;
+}
+
+// Windows with odd pixel counts, fills and images, back to back: the packed
+// stream must not carry a half pixel from one window into the next.
+uint32_t reportPacking() {
+  static uint16_t image[7 * 3];
+  const uint16_t colors[] = {lcd.RED, lcd.GREEN, lcd.BLUE, lcd.WHITE,
+                             lcd.GRAY};
+  std::vector<uint16_t> expected;
+  size_t mark = host::bus.mark();
+
+  for (uint32_t i = 0; i < sizeof(image) / sizeof(image[0]); ++i)
+    image[i] = (i * 0x1357) ^ 0xA5A5;
+  for (uint16_t c : colors) {
+    lcd.fill(1, 1, 3, 3, c);
+    expected.insert(expected.end(), 3 * 3, lcd.rgb444(c));
+    lcd.fill(1, 1, 5, 1, c);
+    expected.insert(expected.end(), 5, lcd.rgb444(c));
+    lcd.fill(0, 0, 131, 1, c);
+    expected.insert(expected.end(), 131, lcd.rgb444(c));
+    lcd.draw(2, 2, 7, 3, image);
+    for (uint16_t pixel : image)
+      expected.push_back(lcd.rgb444(pixel));
+    lcd.draw(2, 2, 7, 1, image);
+    for (uint32_t i = 0; i < 7; ++i)
+      expected.push_back(lcd.rgb444(image[i]));
+  }
+
+  size_t bytes;
+  std::vector<uint16_t> pixels = written(mark, bytes);
+  uint32_t bad = 0;
+  uint32_t missing =
+      expected.size() - std::min(pixels.size(), expected.size());
+
+  for (size_t i = 0; i < std::min(pixels.size(), expected.size()); ++i)
+    bad += pixels[i] != expected[i];
+  printf("\npacking: %s, %zu pixels in %zu bytes, %.2f bytes/pixel, "
+         "%u wrong, %u missing\n",
+         ST7735S_RGB444 ? "RGB444" : "RGB565", expected.size(), bytes,
+         (float)bytes / expected.size(), bad, missing);
+  host::bus.clear();
+  return bad + missing;
+}
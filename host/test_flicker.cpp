@@ -0,0 +1,205 @@
+// The flicker filter ahead of the light profile, on mains-lit traces.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Flicker.h"
+#include "Profile.h"
+#include "Test.h"
+
+// A trace of room light rippling at `hz` with the shots in `starts` and
+// `widths` laid over it, sampled at the profile rate; the shots ramp up and
+// down over 50 samples, like a slow curtain. With `ripple` off the same
+// shots come on a flat, noiseless ambient.
+static const uint32_t FLICKER_RATE = 83333;
+
+static void flickerTrace(uint16_t *samples, uint32_t count, float hz,
+                         bool ripple, const uint32_t *starts,
+                         const uint32_t *widths, uint32_t shots) {
+  const float AMBIENT = 800, RIPPLE = ripple ? 500 : 0, LIGHT = 1500;
+  const uint32_t RAMP = 25;
+
+  for (uint32_t i = 0, shot = 0; i < count; ++i) {
+    // Rectified mains sine with a little of its third harmonic.
+    float phase = (float)M_PI * hz * i / FLICKER_RATE;
+    float light = AMBIENT + RIPPLE * (fabsf(sinf(phase)) +
+                                      0.15f * fabsf(sinf(3 * phase)) +
+                                      0.016f * noise());
+
+    while ((shot < shots) && (i >= starts[shot] + widths[shot] + RAMP))
+      ++shot;
+    if ((shot < shots) && (i + RAMP > starts[shot])) {
+      int32_t in = i + RAMP - starts[shot];
+      int32_t out = starts[shot] + widths[shot] + RAMP - i;
+      int32_t edge = std::min(std::min(in, out), (int32_t)(2 * RAMP));
+
+      light += LIGHT * (edge - 0.5f) / (2 * RAMP);
+    }
+    samples[i] = std::min(light, 4095.0f);
+  }
+}
+
+// Shots from 1/8000 to 1/4 every half second at random phases, as many as
+// fit in `count` samples.
+static uint32_t flickerShots(uint32_t count, uint32_t *starts,
+                             uint32_t *widths) {
+  static const float SPEEDS[] = {8000, 1000, 250, 60, 15, 4};
+  const uint32_t SPACING = FLICKER_RATE / 2;
+  uint32_t state = 7, shots = 0;
+
+  for (uint32_t start = SPACING; start + SPACING < count; start += SPACING) {
+    state = state * 1664525u + 1013904223u;
+    starts[shots] = start + state % (SPACING / 2);
+    widths[shots] = FLICKER_RATE / SPEEDS[shots % 6];
+    ++shots;
+  }
+  return shots;
+}
+
+// Runs a trace through LightProfile, optionally conditioned, and matches the
+// pulses found against the shots laid in. Their 50% widths go to `half`, and
+// are scored against `expected` when given.
+struct FlickerScore {
+  uint32_t found, missed, spurious;
+  double widthError; // mean |half width - expected|, samples
+};
+
+static FlickerScore flickerScore(const uint16_t *trace, uint32_t count,
+                                 const uint32_t *starts,
+                                 const uint32_t *widths, uint32_t shots,
+                                 FlickerFilter *filter, float *half,
+                                 const float *expected = nullptr) {
+  const uint32_t FRAME = 256; // as the ADC task gets them
+  uint16_t chunk[FRAME];
+  LightProfile profile(100, 40);
+  ProfileResult result;
+  FlickerScore score = {0, 0, 0, 0};
+  std::vector<bool> seen(shots);
+
+  for (uint32_t offset = 0; offset < count; offset += FRAME) {
+    uint32_t n = std::min<uint32_t>(FRAME, count - offset);
+
+    std::copy(trace + offset, trace + offset + n, chunk);
+    if (filter) {
+      filter->process(chunk, n);
+      if (!profile.active())
+        profile.trigger(filter->threshold());
+    }
+    for (uint32_t used = 0; used < n;) {
+      used += profile.feed(chunk + used, n - used);
+      if (!profile.pop(result))
+        continue;
+
+      // The pulse ended `holdoff` samples before the sample just used.
+      uint32_t end = offset + used - 40, start = end - result.samples;
+      bool matched = false;
+
+      for (uint32_t i = 0; i < shots; ++i) {
+        if ((start < starts[i] + widths[i]) && (end > starts[i]) &&
+            !seen[i]) {
+          seen[i] = matched = true;
+          half[i] = result.half;
+          if (expected)
+            score.widthError += fabs(result.half - expected[i]);
+          ++score.found;
+          break;
+        }
+      }
+      score.spurious += !matched;
+    }
+  }
+  score.missed = shots - score.found;
+  if (score.found)
+    score.widthError /= score.found;
+  return score;
+}
+
+// Ten seconds of 100 and 120Hz ripple with shots from 1/8000 to 1/4, through
+// LightProfile alone and behind the flicker filter: pulses found, missed and
+// spurious (false edges per second), and how far the 50% width is from that
+// of the same shot on steady light. Then 4 and 8s shots, which the filter
+// must not take for a change of scene, and the filter's cost per sample. Behind the filter every shot must be found,
+// with no false pulses and the width within 20us.
+uint32_t reportFlicker() {
+  static uint16_t trace[15 * FLICKER_RATE], work[10 * FLICKER_RATE];
+  static uint32_t starts[32], widths[32];
+  static float half[32], expected[32];
+  const uint32_t COUNT = sizeof(work) / sizeof(work[0]);
+  uint32_t shots = flickerShots(COUNT, starts, widths), failures = 0;
+
+  printf("\n%-6s %-8s %6s %6s %8s %10s %10s\n", "ripple", "filter",
+         "found", "missed", "false/s", "width us", "ripple pp");
+  for (float hz : {100.0f, 120.0f}) {
+    flickerTrace(trace, COUNT, hz, false, starts, widths, shots);
+    flickerScore(trace, COUNT, starts, widths, shots, nullptr, expected);
+    flickerTrace(trace, COUNT, hz, true, starts, widths, shots);
+    for (bool filtered : {false, true}) {
+      FlickerFilter filter(FLICKER_RATE / hz, 100);
+      FlickerScore score =
+          flickerScore(trace, COUNT, starts, widths, shots,
+                       filtered ? &filter : nullptr, half, expected);
+
+      printf("%-6.0f %-8s %6u %6u %8.1f %10.2f %10s\n", hz,
+             filtered ? "on" : "off", score.found, score.missed,
+             score.spurious / 10.0, score.widthError * 1e6 / FLICKER_RATE,
+             filtered ? std::to_string(filter.ripple()).c_str() : "-");
+      if (filtered) {
+        failures += score.missed || score.spurious ||
+                    (score.widthError * 1e6 / FLICKER_RATE > 20);
+      }
+    }
+  }
+
+  // 4 and 8s shots a second apart, then 1/1000 and 1/60 on their heels: the
+  // template must still be the room's once the light goes off.
+  const uint32_t SLOW_COUNT = sizeof(trace) / sizeof(trace[0]);
+  const uint32_t slowStarts[] = {FLICKER_RATE, 6 * FLICKER_RATE,
+                                 14 * FLICKER_RATE + FLICKER_RATE / 20,
+                                 14 * FLICKER_RATE + FLICKER_RATE / 4};
+  const uint32_t slowWidths[] = {4 * FLICKER_RATE, 8 * FLICKER_RATE,
+                                 FLICKER_RATE / 1000, FLICKER_RATE / 60};
+  const uint32_t SLOW_SHOTS = sizeof(slowStarts) / sizeof(slowStarts[0]);
+
+  for (float hz : {100.0f, 120.0f}) {
+    FlickerFilter filter(FLICKER_RATE / hz, 100);
+
+    flickerTrace(trace, SLOW_COUNT, hz, false, slowStarts, slowWidths,
+                 SLOW_SHOTS);
+    flickerScore(trace, SLOW_COUNT, slowStarts, slowWidths, SLOW_SHOTS,
+                 nullptr, expected);
+    flickerTrace(trace, SLOW_COUNT, hz, true, slowStarts, slowWidths,
+                 SLOW_SHOTS);
+
+    FlickerScore score =
+        flickerScore(trace, SLOW_COUNT, slowStarts, slowWidths, SLOW_SHOTS,
+                     &filter, half, expected);
+
+    printf("%-6.0f %-8s %6u %6u %8.1f %10.2f %10u\n", hz, "on, slow",
+           score.found, score.missed, score.spurious / 15.0,
+           score.widthError * 1e6 / FLICKER_RATE, filter.ripple());
+    failures += score.missed || score.spurious ||
+                (score.widthError * 1e6 / FLICKER_RATE > 20);
+  }
+
+  FlickerFilter filter(FLICKER_RATE / 100.0f, 100);
+  const uint32_t ROUNDS = 20;
+
+  flickerTrace(trace, COUNT, 100, true, starts, widths, shots);
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; ++i) {
+    std::copy(trace, trace + COUNT, work);
+    filter.process(work, COUNT);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("flicker filter: %.2fns/sample (copy included)\n",
+         elapsed.count() * 1e9 / (COUNT * ROUNDS));
+  return failures;
+}
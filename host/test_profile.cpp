@@ -0,0 +1,88 @@
+// Light profiles reduced from synthetic ADC traces.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include <algorithm>
+
+#include "Profile.h"
+#include "Test.h"
+
+// A leaf shutter at the ADC: baseline with noise, a linear opening ramp, the
+// fully open plateau and a closing ramp. With symmetric ramps both the 50%
+// width and the effective exposure equal plateau + ramp.
+static uint32_t waveform(uint16_t *samples, uint32_t ramp, uint32_t plateau) {
+  const uint16_t BASE = 200, PEAK = 3000;
+  const uint32_t QUIET = 400;
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < QUIET; ++i)
+    samples[count++] = BASE + 8 * noise();
+  for (uint32_t i = 0; i < ramp; ++i)
+    samples[count++] = BASE + (PEAK - BASE) * (i + 0.5f) / ramp + 8 * noise();
+  for (uint32_t i = 0; i < plateau; ++i)
+    samples[count++] = PEAK + 8 * noise();
+  for (uint32_t i = 0; i < ramp; ++i)
+    samples[count++] = PEAK - (PEAK - BASE) * (i + 0.5f) / ramp + 8 * noise();
+  for (uint32_t i = 0; i < QUIET; ++i)
+    samples[count++] = BASE + 8 * noise();
+  return count;
+}
+
+// One pulse per shape, whose 50% width and effective exposure are within a
+// sample or 1% of plateau + ramp.
+uint32_t reportProfile() {
+  static uint16_t samples[200000];
+  static const uint32_t SHAPES[][2] = {
+      {4, 8}, {20, 60}, {50, 100}, {200, 2000}};
+  LightProfile profile(100, 40);
+  ProfileResult result;
+  uint32_t failures = 0;
+
+  printf("\n%8s %8s %8s %8s %8s %10s %6s %6s\n", "ramp", "plateau",
+         "expected", "half", "width", "effective", "base", "peak");
+  for (const uint32_t *shape : SHAPES) {
+    uint32_t count = waveform(samples, shape[0], shape[1]), found = 0;
+    float expected = shape[0] + shape[1];
+    float slack = std::max(1.0f, expected / 100);
+
+    // Feed in DMA-frame sized chunks, as the ADC task does.
+    for (uint32_t offset = 0; offset < count;) {
+      uint32_t chunk = count - offset < 256 ? count - offset : 256;
+
+      for (uint32_t used = 0; used < chunk;) {
+        used += profile.feed(samples + offset + used, chunk - used);
+        if (profile.pop(result)) {
+          printf("%8u %8u %8u %8.1f %8u %10.1f %6u %6u\n", shape[0],
+                 shape[1], shape[0] + shape[1], result.half, result.samples,
+                 result.effective, result.baseline, result.peak);
+          ++found;
+          failures += (fabsf(result.half - expected) > slack) ||
+                      (fabsf(result.effective - expected) > slack);
+        }
+      }
+      offset += chunk;
+    }
+    failures += found != 1;
+  }
+
+  uint32_t count = waveform(samples, 50, 100);
+  const uint32_t ROUNDS = 20000;
+  uint32_t pulses = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; ++i) {
+    for (uint32_t used = 0; used < count;) {
+      used += profile.feed(samples + used, count - used);
+      pulses += profile.pop(result);
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("%u samples, %u pulses in %.3fs, %.2fns/sample\n", count * ROUNDS,
+         pulses, elapsed.count(), elapsed.count() * 1e9 / (count * ROUNDS));
+  return failures + (pulses != ROUNDS);
+}
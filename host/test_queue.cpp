@@ -0,0 +1,44 @@
+// The SPSC queue between the capture and render tasks, across threads.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <thread>
+
+#include "SpscQueue.h"
+#include "Test.h"
+
+// Producer and consumer on separate threads hammering a small queue: every
+// value must arrive once and in order. Either side yields when it has to
+// wait, and the overrun count is how often the producer found it full.
+uint32_t reportQueue() {
+  static SpscQueue<uint32_t, 64> queue;
+  const uint32_t ITEMS = 20000000;
+  uint32_t errors = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < ITEMS; ++i) {
+      while (!queue.push(i))
+        std::this_thread::yield();
+    }
+  });
+  for (uint32_t i = 0, item; i < ITEMS;) {
+    if (queue.pop(item)) {
+      errors += item != i;
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("\nspsc: %u items across threads in %.3fs, %.1fM items/s, "
+         "%u out of order, %u full\n",
+         ITEMS, elapsed.count(), ITEMS / elapsed.count() / 1e6, errors,
+         queue.overruns());
+  return errors;
+}
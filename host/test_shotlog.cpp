@@ -0,0 +1,113 @@
+// The shot log on a file-backed flash that can lose power at any byte.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <algorithm>
+
+#include "FileFlash.h"
+#include "ShotLog.h"
+#include "Test.h"
+
+// Fills a small partition several times over for append rate, wear spread
+// and the session index, then cuts the power at every few bytes through a
+// run of sessions and shots. After each cut the log is mounted again and
+// every shot whose append succeeded must still be there, in the session it
+// was written to, and the log must take new shots.
+uint32_t reportShotLog() {
+  typedef ShotLog<host::FileFlash> Log;
+  const uint32_t SECTORS = 64, SHOTS = 100000, PER_SESSION = 100;
+  host::FileFlash flash(tmpfile(), SECTORS * host::FileFlash::SECTOR);
+  Log log(flash);
+  ShotRecord record = {3, 7, {1000, 1480, 1960}, {160000, 160100, 159900}};
+  LogSession sessions[4];
+
+  log.mount();
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < SHOTS; ++i) {
+    if (!(i % PER_SESSION))
+      log.session(TICKS_PER_US);
+    record.width[0] = i;
+    log.append(record);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  uint32_t least = UINT32_MAX, most = 0;
+
+  for (uint32_t i = 0; i < SECTORS; ++i) {
+    least = std::min(least, flash.erases(i));
+    most = std::max(most, flash.erases(i));
+  }
+  printf("\nshot log: %u shots in %.3fs, %.0fk appends/s, erases per "
+         "sector %u-%u\n",
+         SHOTS, elapsed.count(), SHOTS / elapsed.count() / 1e3, least, most);
+
+  Log mounted(flash);
+  uint32_t failures = 0, n;
+
+  mounted.mount();
+  n = mounted.sessions(sessions, 4);
+  failures += n != 4;
+  printf("latest sessions:");
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t shots = mounted.shots(sessions[i], [](const ShotRecord &) {});
+
+    printf(" #%u (%u shots)", sessions[i].number, shots);
+    failures += (sessions[i].number != SHOTS / PER_SESSION - i) ||
+                (shots != PER_SESSION);
+  }
+  printf("\n");
+
+  const uint32_t RUN = 1200, STEP = 61;
+  uint32_t cuts = 0, lost = 0;
+
+  for (uint32_t budget = 0;; budget += STEP) {
+    FILE *file = tmpfile();
+    host::FileFlash small(file, 8 * host::FileFlash::SECTOR);
+    Log before(small), after(small);
+    uint32_t session = 0, acknowledged = 0, shot = 0;
+
+    before.mount();
+    small.cut(budget);
+    for (; shot < RUN; ++shot) {
+      if (!(shot % PER_SESSION)) {
+        if (!before.session(TICKS_PER_US))
+          break;
+        session = before.current();
+        acknowledged = 0;
+      }
+      record.width[0] = shot;
+      if (!before.append(record))
+        break;
+      ++acknowledged;
+    }
+    if (shot == RUN) {
+      fclose(file);
+      break;
+    }
+    ++cuts;
+    small.restore();
+
+    // Shots in the session that was open when the power went.
+    uint32_t found = 0, bad = 0;
+
+    after.mount();
+    if (session && after.sessions(sessions, 1) &&
+        (sessions[0].number == session)) {
+      after.shots(sessions[0], [&](const ShotRecord &r) {
+        bad += r.width[0] != shot - acknowledged + found++;
+      });
+    }
+    bool appended = after.session(TICKS_PER_US) && after.append(record);
+    Log again(small);
+
+    again.mount();
+    lost += (found != acknowledged) || bad || !appended ||
+                !again.sessions(sessions, 1) ||
+                (again.shots(sessions[0], [](const ShotRecord &) {}) != 1);
+    fclose(file);
+  }
+  printf("power loss: %u cut points, %u failed recovery\n", cuts, lost);
+  return failures + lost;
+}
@@ -0,0 +1,63 @@
+// Streaming statistics over synthetic shot series.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "Stats.h"
+#include "Test.h"
+
+// A shutter 10% slow must read about +0.14 EV against the speed it was set to.
+uint32_t reportStats() {
+  static const float SPEEDS[] = {8000, 1000, 125, 30, 2};
+  uint32_t failures = 0;
+
+  printf("\n%-8s %5s %12s %10s %8s %8s  %s\n", "speed", "shots", "mean us",
+         "stddev", "stops", "nominal", "histogram");
+  for (float speed : SPEEDS) {
+    // A slightly slow shutter with 5% spread.
+    float us = 1.1f * 1000000.0f / speed;
+    ShotStats stats(1000000.0f / speed);
+
+    for (uint8_t i = 0; i < 50; ++i)
+      stats.add(us * (1 + 0.05f * noise()));
+
+    char name[12];
+    snprintf(name, sizeof(name), "1/%.0f", speed);
+    printf("%-8s %5u %12.2f %10.2f %+8.3f %8.1f  ", name, stats.count(),
+           stats.mean(), stats.stddev(), stats.stops(), stats.nominal());
+    for (uint8_t i = 0; i < stats.BINS; ++i) {
+      if (stats.bin(i))
+        printf("[%.0f]=%u ", stats.binStart(i), stats.bin(i));
+    }
+    printf("\n");
+    failures += (stats.count() != 50) ||
+                (fabsf(stats.stops() - log2f(1.1f)) > 0.05f) ||
+                (fabsf(stats.nominal() * speed / 1000000.0f - 1) > 0.001f);
+  }
+
+  // Stepping through the marked speeds from one just off a mark, and held at
+  // either end of the scale.
+  failures += (ShotStats::step(1000000.0f / 120, -1) != 1000000.0f / 250) ||
+              (ShotStats::step(1000000.0f / 60, 1) != 1000000.0f / 30) ||
+              (ShotStats::step(1000000.0f / 2, 1) != 1000000.0f) ||
+              (ShotStats::step(1000000.0f / 8000, -1) != 1000000.0f / 8000) ||
+              (ShotStats::step(8000000.0f, 1) != 8000000.0f);
+
+  const uint32_t SHOTS = 10000000;
+  ShotStats stats(1000);
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < SHOTS; ++i)
+    stats.add(1000 + 50 * noise());
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("\n%u shots in %.3fs, %.1fns/shot, mean %.2f stddev %.2f\n", SHOTS,
+         elapsed.count(), elapsed.count() * 1e9 / SHOTS, stats.mean(),
+         stats.stddev());
+  // Uniform noise of +-50 has a standard deviation of 50 / sqrt(3).
+  return failures + (fabsf(stats.mean() - 1000) > 0.5f) +
+         (fabsf(stats.stddev() - 50 / sqrtf(3)) > 0.5f);
+}
@@ -0,0 +1,78 @@
+// Telemetry frames round-tripped through the encoder and decoder.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <algorithm>
+
+#include "Telemetry.h"
+#include "Test.h"
+
+// Round trip through the encoder and decoder: shot records are batched,
+// drained in UART-sized pieces into the reader and checked against what was
+// sent. One frame is then corrupted to show the reader resyncing at the next
+// delimiter and the sequence gap being counted.
+uint32_t reportTelemetry() {
+  static TelemetryWriter<1024> writer;
+  const uint32_t RECORDS = 2000000;
+  TelemetryReader reader;
+  TelemetryRecord decoded;
+  ShotRecord record = {3, 7, {1000, 1480, 1960}, {160000, 160100, 159900}};
+  uint32_t sent = 0, received = 0, errors = 0, bytes = 0;
+
+  // The n-th shot carries n in its last channel.
+  auto drain = [&] {
+    while (writer.pending()) {
+      size_t count = std::min<size_t>(64, writer.pending());
+
+      for (size_t i = 0; i < count; ++i) {
+        if (!reader.feed(writer.data()[i], decoded) ||
+            (decoded.type != Telemetry::SHOT))
+          continue;
+        errors += (decoded.shot.mask != record.mask) ||
+                  (decoded.shot.open[0] != record.open[0]) ||
+                  (decoded.shot.width[2] != received);
+        ++received;
+      }
+      bytes += count;
+      writer.consume(count);
+    }
+  };
+
+  writer.info({TICKS_PER_US, 83333});
+  drain();
+  bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (; sent < RECORDS; ++sent) {
+    record.width[2] = sent;
+    if (writer.pending() + Telemetry::MAX_FRAME > 1024)
+      drain();
+    writer.shot(record);
+  }
+  drain();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf("\ntelemetry: %u records round trip in %.3fs, %.1fM records/s, "
+         "%.1f bytes/record, %u mismatched, %u bad frames, %u lost\n",
+         RECORDS, elapsed.count(), RECORDS / elapsed.count() / 1e6,
+         (float)bytes / RECORDS, errors + sent - received, reader.errors(),
+         reader.lost());
+
+  uint32_t failures = errors + sent - received + reader.errors() +
+                      reader.lost(),
+           before = received;
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    record.width[2] = received + i;
+    writer.shot(record);
+  }
+  // Flip a bit in the middle of the first frame.
+  const_cast<uint8_t *>(writer.data())[10] ^= 0x40;
+  drain();
+  printf("corrupted frame: %u of 3 decoded, %u bad frames, %u lost\n",
+         received - before, reader.errors(), reader.lost());
+  return failures + (received - before != 2) + (reader.errors() != 1) +
+         (reader.lost() != 1);
+}